@@ -56,13 +56,13 @@ static Stm32F4Dshot dshot;
 static DshotEsc esc = DshotEsc(&dshot);
 
 ///////////////////////////////////////////////////////
-static AnglePidController anglePid;
+FAST_DATA static AnglePidController anglePid;
 static Mixer mixer = QuadXbfMixer::make();
-static SoftQuatImu imu(Imu::rotate180);
-static std::vector<PidController *> pids = {&anglePid};
+FAST_DATA static SoftQuatImu imu(Imu::rotate180);
+static PidController::list_t pids = {&anglePid};
 ///////////////////////////////////////////////////////
 
-static Stm32F4Board board(LED_PIN);
+FAST_DATA static Stm32F4Board board(LED_PIN);
 
 // Motor interrupt
 extern "C" void DMA2_Stream1_IRQHandler(void) 
@@ -0,0 +1,98 @@
+/* Copyright (c) 2023 Simon D. Levy 
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Hardware-in-the-loop version of BetaFpvF405Sbus: the real firmware, timed
+// by the real IMU interrupt, flies a vehicle simulated by utils/hil/hilsim.py
+// over USB.  Simulated gyro, accelerometer and SBUS values replace the
+// MPU6000 readings and the receiver, and motor values go back to the host
+// instead of to the ESCs.
+
+#include <hackflight.h>
+#include <boards/stm32f/stm32f4.h>
+#include <core/mixers/fixedpitch/quadxbf.h>
+#include <core/pids/angle.h>
+#include <escs/hil.h>
+#include <hilprotocol.h>
+#include <imus/softquat.h>
+
+#include <SPI.h>
+#include <mpu6x00.h>
+
+static const uint8_t LED_PIN     = PB5;
+static const uint8_t IMU_CS_PIN  = PA4;
+static const uint8_t IMU_INT_PIN = PC4;
+
+static SPIClass spi = SPIClass(
+        Stm32FBoard::MOSI_PIN, Stm32FBoard::MISO_PIN, Stm32FBoard::SCLK_PIN);
+
+// Still started, so that its data-ready interrupt paces the core loop
+static Mpu6000 mpu = Mpu6000(spi, IMU_CS_PIN);
+
+static Hil hil;
+
+static HilEsc esc = HilEsc(hil, Serial);
+
+///////////////////////////////////////////////////////
+FAST_DATA static AnglePidController anglePid;
+static Mixer mixer = QuadXbfMixer::make();
+// The host simulates body-frame sensors, so no board rotation
+FAST_DATA static SoftQuatImu imu(Imu::rotate0);
+static PidController::list_t pids = {&anglePid};
+///////////////////////////////////////////////////////
+
+FAST_DATA static Stm32F4Board board(LED_PIN);
+
+// IMU interrupt
+static void handleImuInterrupt(void)
+{
+    board.handleImuInterrupt(imu);
+}
+
+void setup(void)
+{
+    // USB carries the HIL frames, so MSP goes to the Skyranger UART
+    Serial.begin(2000000);
+    Serial4.begin(115200);
+    board.setMspStream(Serial4);
+
+    spi.begin();
+
+    mpu.begin();
+
+    board.begin(imu, IMU_INT_PIN, handleImuInterrupt);
+}
+
+void loop(void)
+{
+    // Take the host's latest sample in place of the MPU6000 and SBUS
+    while (Serial.available()) {
+
+        if (hil.parse(Serial.read())) {
+
+            board.setSbusValues(
+                    hil.getChannels(), micros(), hil.isLostFrame());
+        }
+    }
+
+    int16_t rawGyro[3] = {};
+    int16_t rawAccel[3] = {};
+
+    hil.getRawGyro(rawGyro);
+    hil.getRawAccel(rawAccel);
+
+    board.step(imu, pids, mixer, esc, rawGyro, rawAccel);
+}
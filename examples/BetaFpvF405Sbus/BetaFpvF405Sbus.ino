@@ -22,6 +22,7 @@
 #include <debug.h>
 #include <escs/dshot.h>
 #include <imus/softquat.h>
+#include <storage/eeprom.h>
 
 #include <sbus.h>
 
@@ -41,6 +42,8 @@ static const uint8_t MOTOR2_PIN = PB_1;
 static const uint8_t MOTOR3_PIN = PA_3;
 static const uint8_t MOTOR4_PIN = PA_2;
 
+// The DShot library takes these as vectors, so they come from the heap at
+// static-initialization time; the FASTMEM linker script leaves one for them
 static std::vector<uint8_t> stream1MotorPins = {MOTOR3_PIN, MOTOR4_PIN};
 static std::vector<uint8_t> stream2MotorPins = {MOTOR1_PIN, MOTOR2_PIN};
 
@@ -56,13 +59,16 @@ static Stm32F4Dshot dshot;
 static DshotEsc esc = DshotEsc(&dshot);
 
 ///////////////////////////////////////////////////////
-static AnglePidController anglePid;
+FAST_DATA static AnglePidController anglePid;
 static Mixer mixer = QuadXbfMixer::make();
-static SoftQuatImu imu(Imu::rotate270);
-static std::vector<PidController *> pids = {&anglePid};
+FAST_DATA static SoftQuatImu imu(Imu::rotate270);
+static PidController::list_t pids = {&anglePid};
 ///////////////////////////////////////////////////////
 
-static Stm32F4Board board(LED_PIN);
+// Parameters edited over MSP are saved here
+static EepromStorage storage;
+
+FAST_DATA static Stm32F4Board board(LED_PIN);
 
 extern "C" void DMA2_Stream1_IRQHandler(void) 
 {
@@ -109,7 +115,7 @@ void setup(void)
 
     mpu.begin();
 
-    board.begin(imu, IMU_INT_PIN, handleImuInterrupt);
+    board.begin(imu, IMU_INT_PIN, handleImuInterrupt, &storage);
 
     dshot.begin(stream1MotorPins, stream2MotorPins);
 }
@@ -0,0 +1,233 @@
+/*
+   Cycle-count benchmark for the core (gyro / receiver / PID / mixer) loop,
+   fed with synthetic sensor and receiver data so that it runs without any
+   hardware attached.  Build and run it under Renode with 'make emulate', or
+   flash it to a board and listen on USART1.
+
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <hackflight.h>
+#include <core/mixers/fixedpitch/quadxbf.h>
+#include <core/pids/angle.h>
+#include <imus/softquat.h>
+
+// One second of core loop at 8 kHz
+static const uint32_t ITERATIONS = 8000;
+
+// Receiver frames arrive at about 100 Hz
+static const uint32_t RECEIVER_PERIOD = 80;
+
+static const uint16_t SBUS_MIN = 172;
+static const uint16_t SBUS_MAX = 1811;
+
+typedef struct {
+
+    const char * name;
+    uint32_t total;
+    uint32_t max;
+
+} stage_t;
+
+///////////////////////////////////////////////////////
+FAST_DATA static AnglePidController anglePid;
+static Mixer mixer = QuadXbfMixer::make();
+FAST_DATA static SoftQuatImu imu(Imu::rotate0);
+///////////////////////////////////////////////////////
+
+static PidController::list_t pids = {&anglePid};
+
+static ReceiverTask receiver;
+
+static VehicleState vstate;
+
+static Parameters params;
+
+static uint32_t getCycleCounter(void)
+{
+    return DWT->CYCCNT;
+}
+
+static void startCycleCounter(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+
+    __O uint32_t *DWTLAR = (uint32_t *)(DWT_BASE + 0x0FB0);
+    *(DWTLAR) = 0xC5ACCE55;
+
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static void addSample(stage_t & stage, const uint32_t cycles)
+{
+    stage.total += cycles;
+
+    if (cycles > stage.max) {
+        stage.max = cycles;
+    }
+}
+
+// Gyro: slow maneuver plus motor-noise tone, in raw sensor counts
+static void makeGyro(const uint32_t k, int16_t rawGyro[3])
+{
+    const auto t = k * PidController::DT;
+
+    const auto noise = 40 * sinf(2 * M_PI * 230 * t);
+
+    rawGyro[0] = (int16_t)(800 * sinf(2 * M_PI * 2 * t) + noise);
+    rawGyro[1] = (int16_t)(600 * sinf(2 * M_PI * 3 * t) - noise);
+    rawGyro[2] = (int16_t)(200 * sinf(2 * M_PI * 1 * t) + noise);
+}
+
+// Receiver: sticks sweeping through their range, throttle above idle
+static void makeReceiver(const uint32_t k, const uint32_t usec)
+{
+    const auto t = k * PidController::DT;
+
+    const auto mid = (SBUS_MIN + SBUS_MAX) / 2;
+    const auto amp = (SBUS_MAX - SBUS_MIN) / 3;
+
+    uint16_t channels[6] = {
+        (uint16_t)(mid + amp / 2),
+        (uint16_t)(mid + amp * sinf(2 * M_PI * 0.5 * t)),
+        (uint16_t)(mid + amp * cosf(2 * M_PI * 0.5 * t)),
+        (uint16_t)(mid + amp * sinf(2 * M_PI * 0.25 * t)),
+        SBUS_MAX,
+        SBUS_MIN
+    };
+
+    receiver.setValues(channels, usec, false, SBUS_MIN, SBUS_MAX);
+
+    receiver.run();
+}
+
+static void calibrateGyro(void)
+{
+    int16_t rawGyro[3] = {};
+
+    do {
+        Imu::gyroRawToFilteredDps(imu, rawGyro, vstate);
+    } while (imu.gyroIsCalibrating());
+}
+
+static void report(const char * label, stage_t stages[], const uint8_t count)
+{
+    Serial.printf("%s (cycles per iteration, %lu iterations)\n",
+            label, (unsigned long)ITERATIONS);
+
+    for (uint8_t k=0; k<count; ++k) {
+        Serial.printf("    %-10s mean %6lu  max %6lu\n",
+                stages[k].name,
+                (unsigned long)(stages[k].total / ITERATIONS),
+                (unsigned long)stages[k].max);
+    }
+}
+
+// Runs the core loop one stage at a time; staticDispatch selects between the
+// qualified-call path used by Logic::step() templates and the virtual path
+static void bench(const char * label, const bool staticDispatch)
+{
+    stage_t stages[] = {
+        {"gyro",     0, 0},
+        {"receiver", 0, 0},
+        {"pid",      0, 0},
+        {"mixer",    0, 0},
+        {"total",    0, 0}
+    };
+
+    // Cost of reading the cycle counter, subtracted from each stage
+    const auto t0 = getCycleCounter();
+    const auto overhead = getCycleCounter() - t0;
+
+    for (uint32_t k=0; k<ITERATIONS; ++k) {
+
+        const auto usec = k * PidController::PERIOD;
+
+        int16_t rawGyro[3] = {};
+        makeGyro(k, rawGyro);
+
+        if (k % RECEIVER_PERIOD == 0) {
+            makeReceiver(k, usec);
+        }
+
+        float motors[Mixer::MAX_MOTORS] = {};
+
+        const auto c0 = getCycleCounter();
+
+        if (staticDispatch) {
+            Imu::gyroRawToFilteredDps(imu, rawGyro, vstate);
+        }
+        else {
+            imu.gyroRawToFilteredDps(rawGyro, vstate);
+        }
+
+        const auto c1 = getCycleCounter();
+
+        Demands demands = receiver.modifyDemands();
+
+        const auto c2 = getCycleCounter();
+
+        const auto reset = receiver.throttleIsDown();
+
+        if (staticDispatch) {
+            PidController::run(demands, vstate, params, usec, reset, anglePid);
+        }
+        else {
+            PidController::run(pids, demands, vstate, params, usec, reset);
+        }
+
+        const auto c3 = getCycleCounter();
+
+        mixer.getMotors(demands, motors);
+
+        const auto c4 = getCycleCounter();
+
+        addSample(stages[0], c1 - c0 - overhead);
+        addSample(stages[1], c2 - c1 - overhead);
+        addSample(stages[2], c3 - c2 - overhead);
+        addSample(stages[3], c4 - c3 - overhead);
+        addSample(stages[4], c4 - c0 - 4 * overhead);
+    }
+
+    report(label, stages, sizeof(stages) / sizeof(stage_t));
+}
+
+void setup(void)
+{
+    Serial.begin(115200);
+
+    startCycleCounter();
+
+    Imu & base = imu;
+    base.begin(SystemCoreClock);
+
+    calibrateGyro();
+
+    Serial.printf("Hackflight core-loop benchmark, %lu MHz core clock\n",
+            (unsigned long)(SystemCoreClock / 1000000));
+
+    bench("static dispatch", true);
+    bench("virtual dispatch", false);
+
+    Serial.printf("done\n");
+}
+
+void loop(void)
+{
+}
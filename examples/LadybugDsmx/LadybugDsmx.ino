@@ -24,13 +24,11 @@
 
 #include <dsmrx.h>
 
-#include <vector>
-
 static Dsm2048 rx;
 
 static Mixer mixer = QuadXbfMixer::make();
 static AnglePidController anglePid;
-static std::vector<PidController *> pids = {&anglePid};
+static PidController::list_t pids = {&anglePid};
 
 static LadybugBoard board;
 
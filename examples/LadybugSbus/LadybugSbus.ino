@@ -24,11 +24,9 @@
 
 #include <sbus.h>
 
-#include <vector>
-
 static Mixer mixer = QuadXbfMixer::make();
 static AnglePidController anglePid;
-static std::vector<PidController *> pids = {&anglePid};
+static PidController::list_t pids = {&anglePid};
 
 static bfs::SbusRx rx(&Serial1);
 
@@ -56,13 +56,12 @@ static Stm32F4Dshot dshot;
 static DshotEsc esc = DshotEsc(&dshot);
 
 ///////////////////////////////////////////////////////
-static AnglePidController anglePid;
+FAST_DATA static AnglePidController anglePid;
 static Mixer mixer = QuadXbfMixer::make();
-static SoftQuatImu imu(Imu::rotate180);
-static std::vector<PidController *> pids = {&anglePid};
+FAST_DATA static SoftQuatImu imu(Imu::rotate180);
 ///////////////////////////////////////////////////////
 
-static Stm32F4Board board(LED_PIN);
+FAST_DATA static Stm32F4Board board(LED_PIN);
 
 // Motor interrupt
 extern "C" void DMA2_Stream1_IRQHandler(void) 
@@ -115,5 +114,7 @@ void loop(void)
     int16_t rawGyro[3] = { mpu.getRawGyroX(), mpu.getRawGyroY(), mpu.getRawGyroZ() };
     int16_t rawAccel[3] = { mpu.getRawAccelX(), mpu.getRawAccelY(), mpu.getRawAccelZ() };
 
-    board.step(imu, pids, mixer, esc, rawGyro, rawAccel);
+    // IMU, ESC and PID controller types are known here, so we use the
+    // static-dispatch version of step()
+    board.step(imu, mixer, esc, rawGyro, rawAccel, anglePid);
 }
@@ -59,7 +59,7 @@ static DshotEsc esc = DshotEsc(&dshot);
 static AnglePidController anglePid;
 static Mixer mixer = QuadXbfMixer::make();
 static SoftQuatImu imu(Imu::rotate0Flip);
-static std::vector<PidController *> pids = {&anglePid};
+static PidController::list_t pids = {&anglePid};
 ///////////////////////////////////////////////////////
 
 static Stm32F4Board board(LED_PIN);
@@ -24,8 +24,6 @@
 #include <imu/softquat.h>
 #include <esc/mock.h>
 
-#include <vector>
-
 #include <SPI.h>
 #include <BMI270.h>
 
@@ -46,18 +44,13 @@ static BMI270 bmi = BMI270(spi,
         BMI270::GYRO_RANGE_2000_DPS,
         BMI270::GYRO_ODR_3200_HZ);
 
-static AnglePidController anglePid(
-        1.441305,     // Rate Kp
-        48.8762,      // Rate Ki
-        0.021160,     // Rate Kd
-        0.0165048,    // Rate Kf
-        0.0); // 3.0; // Level Kp
+static AnglePidController anglePid;
 
 static Mixer mixer = QuadXbfMixer::make();
 
 static SoftQuatImu imu(Imu::rotate0);
 
-static std::vector<PidController *> pids = {&anglePid};
+static PidController::list_t pids = {&anglePid};
 
 static MockEsc esc;
 
@@ -45,12 +45,7 @@ static ICM20689 icm(spi, IMU_CS_PIN);
 
 static std::vector <uint8_t> MOTOR_PINS = {PB_10, PB_7, PB_7, PB_8};
 
-static AnglePidController anglePid(
-        1.441305,     // Rate Kp
-        48.8762,      // Rate Ki
-        0.021160,     // Rate Kd
-        0.0165048,    // Rate Kf
-        0.0); // 3.0; // Level Kp
+static AnglePidController anglePid;
 
 static Mixer mixer = QuadXbfMixer::make();
 
@@ -58,7 +53,7 @@ static Dsm2048 rx;
 
 static SoftQuatImu imu(Imu::rotate90);
 
-static std::vector<PidController *> pids = {&anglePid};
+static PidController::list_t pids = {&anglePid};
 
 static DshotEsc esc(MOTOR_PINS);
 
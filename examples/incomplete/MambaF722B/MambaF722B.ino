@@ -24,8 +24,6 @@
 #include <imu/softquat.h>
 #include <esc/mock.h>
 
-#include <vector>
-
 #include <SPI.h>
 #include <ICM42688.h>
 
@@ -43,18 +41,13 @@ static ICM42688 icm(spi, IMU_CS_PIN);
 
 static volatile bool gotInterrupt;
 
-static AnglePidController anglePid(
-        1.441305,     // Rate Kp
-        48.8762,      // Rate Ki
-        0.021160,     // Rate Kd
-        0.0165048,    // Rate Kf
-        0.0); // 3.0; // Level Kp
+static AnglePidController anglePid;
 
 static Mixer mixer = QuadXbfMixer::make();
 
 static SoftQuatImu imu(Imu::rotate270);
 
-static std::vector<PidController *> pids = {&anglePid};
+static PidController::list_t pids = {&anglePid};
 
 static MockEsc esc;
 
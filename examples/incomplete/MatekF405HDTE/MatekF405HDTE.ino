@@ -63,18 +63,13 @@ static Stm32F4Dshot dshot;
 
 static DshotEsc esc = DshotEsc(&dshot);
 
-static AnglePidController anglePid(
-        1.441305,     // Rate Kp
-        48.8762,      // Rate Ki
-        0.021160,     // Rate Kd
-        0.0165048,    // Rate Kf
-        0.0); // 3.0; // Level Kp
+static AnglePidController anglePid;
 
 static Mixer mixer = QuadXbfMixer::make();
 
 static SoftQuatImu imu(Imu::rotate270Flip);
 
-static std::vector<PidController *> pids = {&anglePid};
+static PidController::list_t pids = {&anglePid};
 
 static Stm32F4Board board(imu, pids, mixer, esc, LED_PIN);
 
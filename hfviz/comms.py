@@ -13,11 +13,112 @@ PARTICULAR PURPOSE. See the GNU General Public License for more details.
 You should have received a copy of the GNU General Public License along with
 Hackflight. If not, see <https://www.gnu.org/licenses/>.  '''
 
+import socket
+
 from serial import Serial
 from threading import Thread
 
 BAUD = 115200
 
+# Largest read from any transport
+READ_SIZE = 4096
+
+# So that a blocked read notices when it's time to stop
+READ_TIMEOUT_SEC = 0.1
+
+
+class SerialTransport:
+
+    def __init__(self, portname):
+
+        self.port = Serial(portname, BAUD, timeout=READ_TIMEOUT_SEC)
+
+    def read(self):
+
+        # Block for the first byte, then take whatever else has arrived
+        data = self.port.read(1)
+
+        waiting = self.port.in_waiting
+
+        return data + self.port.read(min(waiting, READ_SIZE)) if waiting else data
+
+    def write(self, data):
+
+        if self.port.isOpen():
+            self.port.write(data)
+
+    def close(self):
+
+        self.port.close()
+
+
+class UdpTransport:
+
+    # Each write is one datagram, so a whole MSP message goes in one packet
+
+    def __init__(self, host, port):
+
+        self.address = (host, port)
+
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.settimeout(READ_TIMEOUT_SEC)
+
+    def read(self):
+
+        try:
+            data, _ = self.sock.recvfrom(READ_SIZE)
+            return data
+        except socket.timeout:
+            return b''
+
+    def write(self, data):
+
+        self.sock.sendto(data, self.address)
+
+    def close(self):
+
+        self.sock.close()
+
+
+class TcpTransport:
+
+    def __init__(self, host, port):
+
+        self.sock = socket.create_connection((host, port))
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.sock.settimeout(READ_TIMEOUT_SEC)
+
+    def read(self):
+
+        try:
+            return self.sock.recv(READ_SIZE)
+        except socket.timeout:
+            return b''
+
+    def write(self, data):
+
+        self.sock.sendall(data)
+
+    def close(self):
+
+        self.sock.close()
+
+
+def make_transport(name):
+    '''
+    Serial port name, or udp://host:port or tcp://host:port for a simulator
+    or a WiFi-bridged flight controller
+    '''
+
+    for scheme, transport in (('udp://', UdpTransport),
+                              ('tcp://', TcpTransport)):
+
+        if name.startswith(scheme):
+            host, port = name[len(scheme):].rsplit(':', 1)
+            return transport(host, int(port))
+
+    return SerialTransport(name)
+
 
 class Comms:
 
@@ -25,11 +126,7 @@ class Comms:
 
         self.viz = viz
 
-        portname = viz.portsvar.get()
-
-        baud = BAUD
-
-        self.port = Serial(portname, baud)
+        self.transport = make_transport(viz.portsvar.get())
 
         self.thread = Thread(target=self.run)
         self.thread.setDaemon(True)
@@ -38,21 +135,17 @@ class Comms:
 
     def send_message(self, serializer, contents):
 
-        msg = serializer(*contents)
-
-        if self.port.isOpen():
-            self.port.write(msg)
+        self.transport.write(serializer(*contents))
 
     def send_request(self, request):
 
-        self.port.write(request)
+        self.transport.write(request)
 
     def run(self):
 
         while self.running:
             try:
-                byte = self.port.read(1)
-                self.viz.parse(byte)
+                self.viz.parse(self.transport.read())
             except Exception:
                 None
 
@@ -68,4 +161,4 @@ class Comms:
 
         self.running = False
 
-        self.port.close()
+        self.transport.close()
@@ -14,6 +14,11 @@ You should have received a copy of the GNU General Public License along with
 Hackflight. If not, see <https://www.gnu.org/licenses/>.
 '''
 
+# Displays redraw at this rate no matter how fast telemetry arrives
+FRAME_RATE_HZ = 30
+
+FRAME_MSEC = 1000 // FRAME_RATE_HZ
+
 
 class Dialog(object):
 
@@ -21,6 +26,9 @@ class Dialog(object):
 
         self.running = False
 
+        # Telemetry counts as of the last frame drawn
+        self.counts = {}
+
         self.viz = viz
 
         self.width = int(self.viz.canvas['width'])
@@ -36,6 +44,24 @@ class Dialog(object):
 
         self.viz.scheduleTask(delay_msec, self._task)
 
+    def schedule_frame(self):
+
+        self.schedule_display_task(FRAME_MSEC)
+
+    def latest(self, name, default=None):
+        '''
+        Returns the latest value of a telemetry item, and whether it has
+        changed since the last time this dialog asked
+        '''
+
+        value, count = self.viz.telemetry.get(name, default)
+
+        changed = count != self.counts.get(name)
+
+        self.counts[name] = count
+
+        return value, changed
+
     def delete(self, widget):
 
         self.viz.canvas.delete(widget)
@@ -48,6 +74,9 @@ class Dialog(object):
 
         self.running = True
 
+        # Draw the first frame whatever the telemetry
+        self.counts = {}
+
     def stop(self):
 
         self.running = False
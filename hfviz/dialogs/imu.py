@@ -31,7 +31,7 @@ from vehicle import get_vehicle
 
 class ImuDialog(Dialog):
 
-    def __init__(self, viz, simulation=False, vehicleScale=0.1, updateMsec=10):
+    def __init__(self, viz, simulation=False, vehicleScale=0.1):
 
         Dialog.__init__(self, viz)
 
@@ -40,14 +40,13 @@ class ImuDialog(Dialog):
         D = vehicleScale / 2
         L = vehicleScale * 2
 
-        # Update period
-        self.update_msec = updateMsec
-
         # Let these be in World-coordinates (worldview-matrix already applied)
         # In right-handed, counter-clockwise order
-        (self.vehicle_points,
-         self.vehicle_faces,
-         self.vehicle_face_colors) = get_vehicle(W, D, L)
+        points, faces, self.vehicle_face_colors = get_vehicle(W, D, L)
+
+        # Arrays, so that each frame transforms all the points at once
+        self.vehicle_points = np.array(points)
+        self.vehicle_faces = np.array(faces)
 
         # Assume no angles to start
         self.roll_pitch_yaw = None
@@ -60,16 +59,21 @@ class ImuDialog(Dialog):
         self.simulation = simulation
         self.running = False
 
-    def start(self):
+        self.faces = []
 
-        self.schedule_display_task(self.update_msec)
+    def start(self):
 
-        self.running = True
+        Dialog.start(self)
 
-        self.faces = []
+        # One polygon per face, created once and then moved, hidden or shown
+        # on each frame
+        self.faces = [self.viz.canvas.create_polygon((0, 0, 0, 0, 0, 0),
+                                                     fill=color,
+                                                     state=tk.HIDDEN)
+                      for color in self.vehicle_face_colors]
+        self.visible = np.zeros(len(self.faces), dtype=bool)
 
-        self.roll_pitch_yaw_prev = None
-        self.roll_pitch_yaw_change = None
+        self.schedule_frame()
 
     def stop(self):
 
@@ -86,11 +90,12 @@ class ImuDialog(Dialog):
 
         if self.running:
 
-            self.roll_pitch_yaw = self.viz.getRollPitchYaw()
+            self.roll_pitch_yaw, changed = self.latest('attitude', (0, 0, 0))
 
-            self._update()
+            if changed:
+                self._update()
 
-            self.schedule_display_task(self.update_msec)
+            self.schedule_frame()
 
     def _to_screen_coords(self, pv):
 
@@ -98,11 +103,10 @@ class ImuDialog(Dialog):
         dims = [int(s)for s in d]
         width, height = dims[0], dims[1]
 
-        x = width/2*pv[0] + width/2
-        y = -height/2*pv[1] + height/2
-        z = pv[2]
+        x = width/2*pv[:, 0] + width/2
+        y = -height/2*pv[:, 1] + height/2
 
-        return [x, y, z]
+        return np.column_stack((x, y))
 
     def _save(self):
 
@@ -140,9 +144,6 @@ class ImuDialog(Dialog):
 
     def _update(self):
 
-        # Erase previous image
-        self._clear()
-
         # Convert angles to X,Y,Z rotation matrices
 
         # Negate incoming angles for display
@@ -167,42 +168,31 @@ class ImuDialog(Dialog):
 
         rot = np.dot(np.dot(self.yawrot, self.pitchrot), self.rollrot)
 
-        # Draw polygons
-        for i in range(len(self.vehicle_faces)):
-
-            poly = []  # transformed polygon
-
-            for j in range(len(self.vehicle_faces[0])):
-
-                v = self.vehicle_points[self.vehicle_faces[i][j]]
-
-                # Transform the point from 3D to 2D
-                ps = np.dot(v, rot.transpose())
-                p = self._to_screen_coords(ps)
-
-                # Put the screenpoint in the list of transformed vertices
-                poly.append((p[0], p[1]))
+        # Transform the points from 3D to 2D, then gather them by face
+        polys = self._to_screen_coords(
+                np.dot(self.vehicle_points, rot.transpose())
+                )[self.vehicle_faces]
 
-            if self._is_polygon_front_face(poly):  # Backface culling
-                f = self.vehicle_face_colors[i]
-                self.faces.append(self.viz.canvas.create_polygon(*poly,
-                                                                 fill=f))
+        # Backface culling
+        visible = self._is_polygon_front_face(polys)
 
-        # Update angle changes
-        if self.roll_pitch_yaw_prev is not None:
-            self.roll_pitch_yaw_change = [
-                    abs(pair[0]-pair[1])
-                    for pair in zip(self.roll_pitch_yaw,
-                                    self.roll_pitch_yaw_prev)]
-        self.roll_pitch_yaw_prev = self.roll_pitch_yaw
+        # Move the faces we can see, and show or hide only the ones whose
+        # visibility changed
+        canvas = self.viz.canvas
+        for face, poly, show, shown in zip(self.faces, polys,
+                                           visible, self.visible):
+            if show:
+                canvas.coords(face, *poly.ravel())
+            if show != shown:
+                canvas.itemconfigure(face,
+                                     state=(tk.NORMAL if show else tk.HIDDEN))
 
-    def _is_polygon_front_face(self, pts):
+        self.visible = visible
 
-        summa = 0.0
-        num = len(pts)
-        for i in range(num-1):
-            summa += (pts[i+1][0]-pts[i][0])*(pts[i+1][1]+pts[i][1])
+    def _is_polygon_front_face(self, polys):
 
-        summa += (pts[0][0]-pts[num-1][0])*(pts[0][1]+pts[num-1][1])
+        # Shoelace sum over each polygon's edges, for all polygons at once
+        x, y = polys[:, :, 0], polys[:, :, 1]
+        nextx, nexty = np.roll(x, -1, axis=1), np.roll(y, -1, axis=1)
 
-        return summa > 0.0
+        return ((nextx - x) * (nexty + y)).sum(axis=1) > 0.0
@@ -19,8 +19,6 @@ from debugging import debug
 from dialog import Dialog
 import tkinter as tk
 
-UPDATE_MSEC = 1
-
 
 class ReceiverDialog(Dialog):
 
@@ -30,7 +28,7 @@ class ReceiverDialog(Dialog):
 
         self.running = False
 
-    def start(self, delay_msec=UPDATE_MSEC):
+    def start(self):
 
         Dialog.start(self)
 
@@ -41,7 +39,7 @@ class ReceiverDialog(Dialog):
         self.aux1_gauge = self._new_gauge(4, '    Aux1', 'purple')
         self.aux2_gauge = self._new_gauge(5, '    Aux2', 'yellow')
 
-        self.schedule_display_task(delay_msec)
+        self.schedule_frame()
 
     def stop(self):
 
@@ -51,16 +49,18 @@ class ReceiverDialog(Dialog):
 
         if self.running:
 
-            channels = self.viz.getChannels()
+            channels, changed = self.latest('rc', (0,)*6)
+
+            if changed:
 
-            self.throttle_gauge.update(channels[0])  # Throttle
-            self.roll_gauge.update(channels[1])      # Roll
-            self.pitch_gauge.update(channels[2])     # Pitch
-            self.yaw_gauge.update(channels[3])       # Yaw
-            self.aux1_gauge.update(channels[4])      # Aux1
-            self.aux2_gauge.update(channels[5])      # Aux2
+                self.throttle_gauge.update(channels[0])  # Throttle
+                self.roll_gauge.update(channels[1])      # Roll
+                self.pitch_gauge.update(channels[2])     # Pitch
+                self.yaw_gauge.update(channels[3])       # Yaw
+                self.aux1_gauge.update(channels[4])      # Aux1
+                self.aux2_gauge.update(channels[5])      # Aux2
 
-            self.schedule_display_task(UPDATE_MSEC)
+            self.schedule_frame()
 
     def _new_gauge(self, offset, name, color, minval=-1):
 
@@ -97,8 +97,16 @@ class HorizontalGauge(object):
 
         self.label = self._create_label((left+right)/2-25, top+height/2)
 
+        self.value = None
+
     def update(self, newval):
 
+        # Leave the canvas alone when this channel hasn't moved
+        if newval == self.value:
+            return
+
+        self.value = newval
+
         new_width = self.width * (newval-self.minval) / (self.maxval -
                                                          self.minval)
         bbox = self.bbox
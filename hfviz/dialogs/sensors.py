@@ -16,15 +16,12 @@ Hackflight. If not, see <https://www.gnu.org/licenses/>.
 
 
 from dialog import Dialog
-from debugging import debug
 
 import tkinter as tk
 
 
 class SensorsDialog(Dialog):
 
-    UPDATE_MSEC = 1
-
     MOCAP_CTR_X = 190
     MOCAP_DOT_SIZE = 10
     MOCAP_MAXVAL = 50
@@ -40,7 +37,7 @@ class SensorsDialog(Dialog):
 
         Dialog.__init__(self, viz)
 
-    def start(self, delay_msec=UPDATE_MSEC):
+    def start(self):
 
         Dialog.start(self)
 
@@ -72,7 +69,10 @@ class SensorsDialog(Dialog):
                          pixpos[k][0]+pixel_size,
                          pixpos[k][1]+pixel_size), fill='gray')
 
-        self.schedule_display_task(delay_msec)
+        # Pixel colors as last drawn
+        self.ranger_fills = [None] * SensorsDialog.RANGER_PIXEL_COUNT
+
+        self.schedule_frame()
 
     def _add_box(self, ctr_x, label):
 
@@ -95,29 +95,42 @@ class SensorsDialog(Dialog):
 
             # Display PAA3905 mocap -------------------------------------------
 
-            mocap_dx, mocap_dy = self.viz.getMocap()
-
-            mocap_dot_x = SensorsDialog._scale_mocap(mocap_dx) + SensorsDialog.MOCAP_CTR_X
-            mocap_dot_y = SensorsDialog._scale_mocap(mocap_dy) + SensorsDialog.SQUARE_CTR_Y
+            (mocap_dx, mocap_dy), changed = self.latest('mocap', (0, 0))
 
-            mocap_dot_size = SensorsDialog.MOCAP_DOT_SIZE // 2
-
-            self.canvas.coords(self.mocap_dot,
-                               (mocap_dot_x - mocap_dot_size,
-                                mocap_dot_y - mocap_dot_size,
-                                mocap_dot_x + mocap_dot_size,
-                                mocap_dot_y + mocap_dot_size))
+            if changed:
+                self._move_mocap_dot(mocap_dx, mocap_dy)
 
             # Display VL53l% ranging --------------------------------------------
 
-            for k, val in enumerate(self.viz.getRanger()):
-                scaled = int(val / SensorsDialog.RANGER_MAXVAL * 256)
-                self.canvas.itemconfig(self.ranger_pixels[k],
-                                       fill='#' + ('%02X' % scaled)*3)
-            debug('')
+            ranger, changed = self.latest('ranger', (16,)*16)
+
+            if changed:
+                self._color_ranger_pixels(ranger)
 
             # Reschedule this display task
-            self.schedule_display_task(SensorsDialog.UPDATE_MSEC)
+            self.schedule_frame()
+
+    def _move_mocap_dot(self, mocap_dx, mocap_dy):
+
+        mocap_dot_x = SensorsDialog._scale_mocap(mocap_dx) + SensorsDialog.MOCAP_CTR_X
+        mocap_dot_y = SensorsDialog._scale_mocap(mocap_dy) + SensorsDialog.SQUARE_CTR_Y
+
+        mocap_dot_size = SensorsDialog.MOCAP_DOT_SIZE // 2
+
+        self.canvas.coords(self.mocap_dot,
+                           (mocap_dot_x - mocap_dot_size,
+                            mocap_dot_y - mocap_dot_size,
+                            mocap_dot_x + mocap_dot_size,
+                            mocap_dot_y + mocap_dot_size))
+
+    def _color_ranger_pixels(self, ranger):
+
+        for k, val in enumerate(ranger):
+            scaled = int(val / SensorsDialog.RANGER_MAXVAL * 256)
+            fill = '#' + ('%02X' % scaled)*3
+            if fill != self.ranger_fills[k]:
+                self.canvas.itemconfig(self.ranger_pixels[k], fill=fill)
+                self.ranger_fills[k] = fill
 
     def _scale_mocap(val):
 
@@ -0,0 +1,158 @@
+'''
+This file is part of Hackflight.
+
+Hackflight is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Hackflight is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Hackflight. If not, see <https://www.gnu.org/licenses/>.
+'''
+
+from dialog import Dialog
+from math import log10
+
+import tkinter as tk
+
+
+class SpectrumDialog(Dialog):
+    '''
+    Live gyro spectrum, one plot per axis, with the unfiltered rate in red and
+    the filtered rate in green, so filter effectiveness can be judged in the
+    field.  Magnitudes are on a log scale.
+    '''
+
+    AXES = 'Roll', 'Pitch', 'Yaw'
+
+    LEFT = 90
+    RIGHT = 760
+    TOP = 40
+    PLOT_HEIGHT = 140
+    PLOT_SPACING = 185
+
+    # Magnitude range in deg/sec
+    MIN_DPS = 0.1
+    MAX_DPS = 1000
+
+    UNFILTERED_COLOR = 'red'
+    FILTERED_COLOR = 'green'
+
+    def __init__(self, viz):
+
+        Dialog.__init__(self, viz)
+
+    def start(self):
+
+        Dialog.start(self)
+
+        self.canvas = self.viz.canvas
+
+        self.lines = []
+
+        for k, axis in enumerate(SpectrumDialog.AXES):
+
+            top = SpectrumDialog.TOP + k * SpectrumDialog.PLOT_SPACING
+            bottom = top + SpectrumDialog.PLOT_HEIGHT
+
+            self.canvas.create_rectangle((SpectrumDialog.LEFT - 1, top - 1,
+                                          SpectrumDialog.RIGHT + 1, bottom + 1),
+                                         outline='white')
+
+            self._create_label(10, (top + bottom) / 2, axis)
+
+            for dps in (1, 10, 100):
+                y = self._scale_magnitude(dps, top)
+                self.canvas.create_line((SpectrumDialog.LEFT, y,
+                                         SpectrumDialog.RIGHT, y),
+                                        fill='gray25')
+                self._create_label(SpectrumDialog.LEFT - 40, y, str(dps))
+
+            self.lines.append(
+                    [self.canvas.create_line((0, 0, 0, 0), fill=color)
+                     for color in (SpectrumDialog.UNFILTERED_COLOR,
+                                   SpectrumDialog.FILTERED_COLOR)])
+
+        self.freq_labels = []
+
+        self._create_label(SpectrumDialog.LEFT, 10,
+                           'deg/sec: unfiltered (red), filtered (green)')
+
+        # Bins as last drawn, so unchanged channels can be skipped
+        self.drawn = [None] * 2 * len(SpectrumDialog.AXES)
+
+        self.schedule_frame()
+
+    def _task(self):
+
+        if self.running:
+
+            (rate, spectra), changed = self.latest('spectrum', (0, ()))
+
+            if changed and rate > 0:
+
+                self._label_frequencies(rate)
+
+                for channel, bins in enumerate(spectra):
+
+                    if bins is self.drawn[channel]:
+                        continue
+
+                    self.drawn[channel] = bins
+
+                    axis = channel % 3
+                    filtered = channel // 3
+
+                    top = SpectrumDialog.TOP + axis * SpectrumDialog.PLOT_SPACING
+
+                    coords = []
+
+                    for k, value in enumerate(bins):
+                        coords.append(self._scale_bin(k, len(bins)))
+                        coords.append(self._scale_magnitude(value / 10, top))
+
+                    self.canvas.coords(self.lines[axis][filtered], coords)
+
+            self.schedule_frame()
+
+    def _label_frequencies(self, rate):
+
+        # Once is enough
+        if len(self.freq_labels) > 0:
+            return
+
+        bottom = (SpectrumDialog.TOP + 2 * SpectrumDialog.PLOT_SPACING +
+                  SpectrumDialog.PLOT_HEIGHT)
+
+        nyquist = rate // 2
+
+        for freq in range(0, nyquist + 1, nyquist // 4):
+            x = SpectrumDialog.LEFT + ((SpectrumDialog.RIGHT -
+                                        SpectrumDialog.LEFT) * freq / nyquist)
+            self.freq_labels.append(
+                    self._create_label(x - 15, bottom + 15, '%d Hz' % freq))
+
+    def _scale_bin(self, k, count):
+
+        return (SpectrumDialog.LEFT +
+                (SpectrumDialog.RIGHT - SpectrumDialog.LEFT) * k / count)
+
+    def _scale_magnitude(self, dps, top):
+
+        lo = log10(SpectrumDialog.MIN_DPS)
+        hi = log10(SpectrumDialog.MAX_DPS)
+
+        value = log10(max(dps, SpectrumDialog.MIN_DPS))
+
+        return (top + SpectrumDialog.PLOT_HEIGHT *
+                (1 - (min(value, hi) - lo) / (hi - lo)))
+
+    def _create_label(self, x, y, text=''):
+
+        return self.canvas.create_text(x, y, anchor=tk.W,
+                                       font=('Helvetica', 12),
+                                       fill='white', text=text)
@@ -0,0 +1,303 @@
+#!/usr/bin/python3
+'''
+This file is part of Hackflight.
+
+Hackflight is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Hackflight is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Hackflight. If not, see <https://www.gnu.org/licenses/>.
+'''
+
+'''
+Headless telemetry recorder.  Polls the flight controller for the chosen MSP
+messages as fast as it answers (or at a fixed rate), and writes each reply,
+stamped with the host time it arrived, to an .npz file.  Each message gets a
+structured array with a 'time' column and one column per message field.
+
+Usage:
+
+    % python3 hfrecord.py /dev/ttyACM0 -m ATTITUDE RC -d 60
+    % python3 hfrecord.py udp://127.0.0.1:5762 -o bench.npz
+
+Load a recording with load(), or with numpy directly: the file holds one
+member per chunk of rows, named MESSAGE_NNNNN.
+'''
+
+from argparse import ArgumentParser
+from inspect import signature
+from queue import Queue
+from signal import signal, SIGTERM
+from threading import Thread
+import time
+import zipfile
+
+import numpy as np
+
+from comms import make_transport
+from mspparser import MspParser
+
+# Rows per chunk handed to the writer thread
+CHUNK_ROWS = 4096
+
+# Re-send a request whose reply never came after this long
+REPLY_TIMEOUT_SEC = 0.5
+
+
+class MessageLog(object):
+    '''
+    Fills fixed-size chunks of rows for one message, and hands each full
+    chunk to the writer
+    '''
+
+    def __init__(self, name, layout, writer):
+
+        self.name = name
+        self.writer = writer
+
+        fields = list(signature(getattr(MspParser,
+                                        'handle_' + name)).parameters)[1:]
+
+        self.dtype = np.dtype([('time', '<f8')] +
+                              [(field, np.dtype(code))
+                               for field, code in zip(fields,
+                                                      layout.format[1:])])
+
+        self.request = getattr(MspParser, 'serialize_%s_Request' % name)()
+
+        # Request bookkeeping
+        self.pending = False
+        self.sent = 0
+        self.due = 0
+
+        self.count = 0
+        self.chunks = 0
+        self._new_chunk()
+
+    def add(self, stamp, values):
+
+        self.rows[self.size] = (stamp,) + values
+        self.size += 1
+        self.count += 1
+
+        if self.size == CHUNK_ROWS:
+            self.flush()
+
+    def flush(self):
+
+        if self.size > 0:
+            self.writer.put('%s_%05d' % (self.name, self.chunks),
+                            self.rows[:self.size])
+            self.chunks += 1
+            self._new_chunk()
+
+    def _new_chunk(self):
+
+        self.rows = np.empty(CHUNK_ROWS, dtype=self.dtype)
+        self.size = 0
+
+
+class Writer(object):
+    '''
+    Writes chunks to the .npz file on its own thread, so that the disk never
+    holds up reading.  The file is reopened for each chunk, so whatever has
+    been written so far is readable even if the recorder is killed.
+    '''
+
+    def __init__(self, filename):
+
+        self.filename = filename
+        self.queue = Queue()
+
+        # Start with an empty archive
+        zipfile.ZipFile(filename, 'w').close()
+
+        self.thread = Thread(target=self._run)
+        self.thread.start()
+
+    def put(self, member, rows):
+
+        self.queue.put((member, rows))
+
+    def close(self):
+
+        self.queue.put(None)
+        self.thread.join()
+
+    def _run(self):
+
+        while True:
+
+            item = self.queue.get()
+
+            if item is None:
+                break
+
+            member, rows = item
+
+            with zipfile.ZipFile(self.filename, 'a') as archive:
+                with archive.open(member + '.npy', 'w') as npy:
+                    np.lib.format.write_array(npy, rows)
+
+
+class Recorder(object):
+
+    def __init__(self, transport, names, rate, writer):
+
+        self.transport = transport
+
+        self.period = 1 / rate if rate > 0 else 0
+
+        self.logs = {}
+
+        # Handlers for the messages we record; the rest are ignored
+        handlers = {}
+
+        for msgid, (layout, handler) in MspParser.MESSAGES.items():
+
+            name = handler[len('handle_'):]
+
+            if name in names:
+                log = MessageLog(name, layout, writer)
+                self.logs[name] = log
+                handlers[handler] = self._make_handler(log)
+
+            else:
+                handlers[handler] = Recorder._ignore
+
+        parser_class = type('RecorderParser', (MspParser,), handlers)
+
+        self.parser = parser_class()
+
+        self.stamp = 0
+
+    def step(self):
+
+        data = self.transport.read()
+
+        self.stamp = time.time()
+
+        self.parser.parse(data)
+
+        self._send_requests(time.monotonic())
+
+    def flush(self):
+
+        for log in self.logs.values():
+            log.flush()
+
+    def _make_handler(self, log):
+
+        def handler(parser, *values):
+
+            log.add(self.stamp, values)
+
+            log.pending = False
+
+        return handler
+
+    def _send_requests(self, now):
+
+        for log in self.logs.values():
+
+            if log.pending and now - log.sent > REPLY_TIMEOUT_SEC:
+                log.pending = False
+
+            if not log.pending and now >= log.due:
+                self.transport.write(log.request)
+                log.pending = True
+                log.sent = now
+                log.due = max(log.due + self.period, now)
+
+    @staticmethod
+    def _ignore(parser, *values):
+
+        return
+
+
+def load(filename):
+    '''
+    Returns a dictionary of message name => structured array of all rows
+    '''
+
+    chunks = {}
+
+    with np.load(filename) as archive:
+
+        for member in sorted(archive.files):
+            name = member.rsplit('_', 1)[0]
+            chunks.setdefault(name, []).append(archive[member])
+
+    return {name: np.concatenate(rows) for name, rows in chunks.items()}
+
+
+def main():
+
+    names = [handler[len('handle_'):]
+             for _, handler in MspParser.MESSAGES.values()]
+
+    argparser = ArgumentParser()
+
+    argparser.add_argument('port',
+                           help='serial port, udp://host:port or ' +
+                           'tcp://host:port')
+    argparser.add_argument('-m', '--messages', nargs='+',
+                           default=['ATTITUDE', 'RC'], choices=names,
+                           help='messages to record')
+    argparser.add_argument('-o', '--output',
+                           default=time.strftime('telemetry-%Y%m%d-%H%M%S.npz'),
+                           help='output file')
+    argparser.add_argument('-r', '--rate', type=float, default=0,
+                           help='requests per second for each message ' +
+                           '(default: as fast as the board replies)')
+    argparser.add_argument('-d', '--duration', type=float, default=0,
+                           help='seconds to record (default: until stopped)')
+
+    args = argparser.parse_args()
+
+    # Stop cleanly when run as a service
+    def terminate(signum, frame):
+        raise KeyboardInterrupt
+
+    signal(SIGTERM, terminate)
+
+    transport = make_transport(args.port)
+
+    writer = Writer(args.output)
+
+    recorder = Recorder(transport, args.messages, args.rate, writer)
+
+    print('Recording %s to %s' % (', '.join(args.messages), args.output))
+
+    start = time.monotonic()
+
+    try:
+
+        while (args.duration == 0 or
+               time.monotonic() - start < args.duration):
+            recorder.step()
+
+    except KeyboardInterrupt:
+
+        pass
+
+    elapsed = time.monotonic() - start
+
+    recorder.flush()
+    writer.close()
+    transport.close()
+
+    for name, log in recorder.logs.items():
+        print('%-15s %8d messages  %8.1f /sec' %
+              (name, log.count, log.count / elapsed))
+
+
+if __name__ == '__main__':
+
+    main()
@@ -18,15 +18,18 @@ Hackflight. If not, see <https://www.gnu.org/licenses/>.
 from comms import Comms
 from serial.tools.list_ports import comports
 import os
+import sys
 import tkinter as tk
 from numpy import radians as rad
 
 from mspparser import MspParser
+from telemetry import Telemetry
 
 from dialogs.imu import ImuDialog
 from dialogs.motors import MotorsQuadXmwDialog, MotorsCoaxialDialog
 from dialogs.receiver import ReceiverDialog
 from dialogs.sensors import SensorsDialog
+from dialogs.spectrum import SpectrumDialog
 
 from resources import resource_path
 from debugging import debug
@@ -47,10 +50,16 @@ USB_UPDATE_MSEC = 200
 
 class Viz(MspParser):
 
-    def __init__(self):
+    def __init__(self, netports=()):
 
         MspParser.__init__(self)
 
+        # Simulator or WiFi-bridge endpoints, offered alongside serial ports
+        self.netports = list(netports)
+
+        # Latest values from the comms thread, drawn by the dialogs
+        self.telemetry = Telemetry()
+
         # No communications or arming yet
         self.comms = None
         self.armed = False
@@ -91,6 +100,8 @@ class Viz(MspParser):
                                                 self._receiver_button_callback)
         self.sensors_button = self._add_button('Sensors', self.pane2,
                                                self._sensors_button_callback)
+        self.spectrum_button = self._add_button('Spectrum', self.pane2,
+                                                self._spectrum_button_callback)
 
         # Prepare for adding ports as they are detected by our timer task
         self.portsvar = tk.StringVar(self.root)
@@ -122,6 +133,9 @@ class Viz(MspParser):
         # Creaate sensors dialog
         self.sensors_dialog = SensorsDialog(self)
 
+        # Create gyro spectrum dialog
+        self.spectrum_dialog = SpectrumDialog(self)
+
         # Create IMU dialog
         self.imu_dialog = ImuDialog(self)
         self._schedule_connection_task()
@@ -135,17 +149,13 @@ class Viz(MspParser):
         self.rc_request = MspParser.serialize_RC_Request()
         self.paa3905_request = MspParser.serialize_PAA3905_Request()
         self.vl53l5_request = MspParser.serialize_VL53L5_Request()
+        self.boot_times_request = MspParser.serialize_BOOT_TIMES_Request()
+        self.spectrum_request = MspParser.serialize_GYRO_SPECTRUM_Request()
+        self.parameters_request = MspParser.serialize_PARAMETERS_Request()
+        self.loop_rate_request = MspParser.serialize_LOOP_RATE_Request()
 
-        # No messages yet
-        self.roll_pitch_yaw = [0]*3
-        self.rxchannels = [0]*6
-        self.mocap = [0]*2
-        self.ranger = [16]*2
-
-        self.mock_mocap_xdir = +1
-        self.mock_mocap_ydir = -1
-        self.mock_mocap_dx = 0
-        self.mock_mocap_dy = 0
+        # Gyro spectrum channels arrive one at a time
+        self.spectra = [[0]*32 for _ in range(6)]
 
     def quit(self):
         self.motors_quadxmw_dialog.stop()
@@ -156,31 +166,6 @@ class Viz(MspParser):
 
         widget.place(x=-9999)
 
-    def getChannels(self):
-
-        return self.rxchannels
-
-    def getRanger(self):
-
-        return self.ranger
-
-    def getMocap(self):
-
-        return self.mocap
-
-    def getRollPitchYaw(self):
-
-        # Configure widgets to show connected
-        self._enable_widget(self.motors_button)
-        self._enable_widget(self.receiver_button)
-        self._enable_widget(self.sensors_button)
-        self._disable_widget(self.portsmenu)
-
-        self.button_connect['text'] = 'Disconnect'
-        self._enable_widget(self.button_connect)
-
-        return self.roll_pitch_yaw
-
     def scheduleTask(self, delay_msec, task):
 
         self.root.after(delay_msec, task)
@@ -199,12 +184,12 @@ class Viz(MspParser):
             return 2 * norm(x) - 1
 
         # Scale throttle from [-1,+1] to [0,1]
-        self.rxchannels = (norm(c1),
+        self.telemetry.put('rc', (norm(c1),
                            scale(c2),
                            scale(c3),
                            scale(c4),
                            scale(c5),
-                           scale(c6))
+                           scale(c6)))
 
         # As soon as we handle the callback from one request, send another
         # request, if receiver dialog is running
@@ -213,7 +198,8 @@ class Viz(MspParser):
 
     def handle_ATTITUDE(self, angx, angy, heading):
 
-        self.roll_pitch_yaw = rad(angx/10), -rad(angy/10), rad(heading)
+        self.telemetry.put('attitude',
+                           (rad(angx/10), -rad(angy/10), rad(heading)))
 
         self.gotimu = True
 
@@ -226,8 +212,9 @@ class Viz(MspParser):
                       p11, p12, p13, p14, p21, p22, p23, p24,
                       p31, p32, p33, p34, p41, p42, p43, p44):
 
-        self.ranger = (p11, p12, p13, p14, p21, p22, p23, p24,
-                       p31, p32, p33, p34, p41, p42, p43, p44)
+        self.telemetry.put('ranger',
+                           (p11, p12, p13, p14, p21, p22, p23, p24,
+                            p31, p32, p33, p34, p41, p42, p43, p44))
 
         # As soon as we handle the callback from one request, send another
         # request, if receiver dialog is running
@@ -236,13 +223,53 @@ class Viz(MspParser):
 
     def handle_PAA3905(self, x, y):
 
-        self.mocap = (x, y)
+        self.telemetry.put('mocap', (x, y))
 
         # As soon as we handle the callback from one request, send another
         # request, if receiver dialog is running
         if self.sensors_dialog.running:
             self._send_paa3905_request()
 
+    def handle_BOOT_TIMES(self, start, running, gyro, esc, armable):
+
+        def fmt(msec):
+
+            return '%5.2f sec' % (msec / 1000) if msec > 0 else 'not yet'
+
+        debug('Boot times from power-on:')
+        debug('    board start:     ' + fmt(start))
+        debug('    tasks running:   ' + fmt(running))
+        debug('    gyro calibrated: ' + fmt(gyro))
+        debug('    ESCs ready:      ' + fmt(esc))
+        debug('    ready to arm:    ' + fmt(armable))
+
+    def handle_GYRO_SPECTRUM(self, channel, rate, *bins):
+
+        self.spectra[channel] = bins
+        self.telemetry.put('spectrum', (rate, tuple(self.spectra)))
+
+        # As soon as we handle the callback from one request, send another
+        # request, if spectrum dialog is running; the board sends the
+        # channels in turn
+        if self.spectrum_dialog.running:
+            self._send_spectrum_request()
+
+    def handle_PARAMETERS(self, *values):
+
+        debug('Parameters:')
+
+        for k, value in enumerate(values):
+            debug('    %2d: %g' % (k, value))
+
+    def handle_LOOP_RATE(self, freq_hz, core_percent, headroom):
+
+        if freq_hz == 0:
+            debug('Loop rate: not chosen yet')
+            return
+
+        debug('Loop rate: %d Hz, core path %d%% of loop (%d%% headroom wanted)'
+              % (freq_hz, core_percent, headroom))
+
     def _add_pane(self):
 
         pane = tk.PanedWindow(self.frame, bg=BACKGROUND_COLOR)
@@ -274,19 +301,37 @@ class Viz(MspParser):
         self._enable_widget(self.motors_button)
         self._enable_widget(self.receiver_button)
         self._enable_widget(self.sensors_button)
+        self._enable_widget(self.spectrum_button)
 
         self.motors_quadxmw_dialog.stop()
         self.motors_coaxial_dialog.stop()
         self.receiver_dialog.stop()
         self.sensors_dialog.stop()
+        self.spectrum_dialog.stop()
         self._send_attitude_request()
         self.imu_dialog.start()
 
     def _start(self):
 
+        # Report how long the board took to start up, the loop rate it
+        # chose, and its parameters
+        self.comms.send_request(self.boot_times_request)
+        self.comms.send_request(self.loop_rate_request)
+        self.comms.send_request(self.parameters_request)
+
         self._send_attitude_request()
         self.imu_dialog.start()
 
+        # Configure widgets to show connected
+        self._enable_widget(self.motors_button)
+        self._enable_widget(self.receiver_button)
+        self._enable_widget(self.sensors_button)
+        self._enable_widget(self.spectrum_button)
+        self._disable_widget(self.portsmenu)
+
+        self.button_connect['text'] = 'Disconnect'
+        self._enable_widget(self.button_connect)
+
         self.gotimu = False
         self.hide(self.error_label)
         self.scheduleTask(CONNECTION_DELAY_MSEC, self._checkimu)
@@ -319,6 +364,10 @@ class Viz(MspParser):
     def _send_paa3905_request(self):
         self.comms.send_request(self.paa3905_request)
 
+    # Sends gyro spectrum request to FC
+    def _send_spectrum_request(self):
+        self.comms.send_request(self.spectrum_request)
+
     # Callback for Motors button
     def _motors_button_callback(self):
 
@@ -328,10 +377,12 @@ class Viz(MspParser):
         self._disable_widget(self.motors_button)
         self._enable_widget(self.receiver_button)
         self._enable_widget(self.sensors_button)
+        self._enable_widget(self.spectrum_button)
 
         self.imu_dialog.stop()
         self.receiver_dialog.stop()
         self.sensors_dialog.stop()
+        self.spectrum_dialog.stop()
         self.motors_quadxmw_dialog.start()
 
     def _clear(self):
@@ -347,9 +398,11 @@ class Viz(MspParser):
         self._enable_widget(self.motors_button)
         self._disable_widget(self.receiver_button)
         self._enable_widget(self.sensors_button)
+        self._enable_widget(self.spectrum_button)
 
         self.imu_dialog.stop()
         self.sensors_dialog.stop()
+        self.spectrum_dialog.stop()
         self.motors_quadxmw_dialog.stop()
         self.motors_coaxial_dialog.stop()
         self._send_rc_request()
@@ -364,15 +417,36 @@ class Viz(MspParser):
         self._enable_widget(self.motors_button)
         self._enable_widget(self.receiver_button)
         self._disable_widget(self.sensors_button)
+        self._enable_widget(self.spectrum_button)
 
         self.imu_dialog.stop()
         self.receiver_dialog.stop()
+        self.spectrum_dialog.stop()
         self.motors_quadxmw_dialog.stop()
         self.motors_coaxial_dialog.stop()
         self._send_vl53l5_request()
         self._send_paa3905_request()
         self.sensors_dialog.start()
 
+    # Callback for Spectrum button
+    def _spectrum_button_callback(self):
+
+        self._clear()
+
+        self._enable_widget(self.imu_button)
+        self._enable_widget(self.motors_button)
+        self._enable_widget(self.receiver_button)
+        self._enable_widget(self.sensors_button)
+        self._disable_widget(self.spectrum_button)
+
+        self.imu_dialog.stop()
+        self.receiver_dialog.stop()
+        self.sensors_dialog.stop()
+        self.motors_quadxmw_dialog.stop()
+        self.motors_coaxial_dialog.stop()
+        self._send_spectrum_request()
+        self.spectrum_dialog.start()
+
     # Callback for Connect / Disconnect button
     def _connect_button_callback(self):
 
@@ -382,6 +456,7 @@ class Viz(MspParser):
             self.motors_quadxmw_dialog.stop()
             self.motors_coaxial_dialog.stop()
             self.receiver_dialog.stop()
+            self.spectrum_dialog.stop()
 
             if self.comms is not None:
 
@@ -393,6 +468,7 @@ class Viz(MspParser):
             self._disable_widget(self.motors_button)
             self._disable_widget(self.receiver_button)
             self._disable_widget(self.sensors_button)
+            self._disable_widget(self.spectrum_button)
 
             self.button_connect['text'] = 'Connect'
             self._enable_widget(self.portsmenu)
@@ -431,7 +507,7 @@ class Viz(MspParser):
                 if portname not in ('COM1', 'COM2'):
                     ports.append(portname)
 
-        return ports
+        return ports + self.netports
 
     # Checks for changes in port status (hot-plugging USB cables)
     def _connection_task(self):
@@ -496,7 +572,9 @@ class Viz(MspParser):
 
 def main():
 
-    Viz()
+    # Network endpoints, e.g. udp://127.0.0.1:5762 or tcp://10.0.0.5:23, can
+    # be given on the command line
+    Viz(sys.argv[1:])
     tk.mainloop()
 
 
@@ -10,69 +10,61 @@ import struct
 
 import abc
 
+from functools import reduce
+from operator import xor
+
 
 class MspParser(metaclass=abc.ABCMeta):
 
+    # Messages from the flight controller: ID => (payload layout, handler)
+    MESSAGES = {
+        105: (struct.Struct('=hhhhhh'), 'handle_RC'),
+        108: (struct.Struct('=hhh'), 'handle_ATTITUDE'),
+        121: (struct.Struct('=hhhhhhhhhhhhhhhh'), 'handle_VL53L5'),
+        122: (struct.Struct('=hh'), 'handle_PAA3905'),
+        123: (struct.Struct('=hhhhh'), 'handle_BOOT_TIMES'),
+        124: (struct.Struct('=hhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhhh'), 'handle_GYRO_SPECTRUM'),
+        125: (struct.Struct('=fffffffffffffffffff'), 'handle_PARAMETERS'),
+        126: (struct.Struct('=hhh'), 'handle_LOOP_RATE'),
+    }
+
     def __init__(self):
-        self.state = 0
-
-    def parse(self, char):
-        byte = ord(char)
-
-        if self.state == 0:  # sync char 1
-            if byte == 36:  # $
-                self.state += 1
-
-        elif self.state == 1:  # sync char 2
-            if byte == 77:  # M
-                self.state += 1
-            else:  # restart and try again
-                self.state = 0
-
-        elif self.state == 2:  # direction
-            if byte == 62:  # >
-                self.message_direction = 1
-            else:  # <
-                self.message_direction = 0
-            self.state += 1
-
-        elif self.state == 3:
-            self.message_length_expected = byte
-            self.message_checksum = byte
-            # setup arraybuffer
-            self.message_buffer = b""
-            self.state += 1
-
-        elif self.state == 4:
-            self.message_id = byte
-            self.message_length_received = 0
-            self.message_checksum ^= byte
-            if self.message_length_expected > 0:
-                # process payload
-                self.state += 1
-            else:
-                # no payload
-                self.state += 2
-
-        elif self.state == 5:  # payload
-            self.message_buffer += char
-            self.message_checksum ^= byte
-            self.message_length_received += 1
-            if self.message_length_received >= self.message_length_expected:
-                self.state += 1
-
-        elif self.state == 6:
-            if self.message_checksum == byte:
-                # message received, process
+        self.buffer = bytearray()
+        # ID => (decoder, payload size, bound handler)
+        self.dispatch = {
+            msgid: (layout.unpack, layout.size, getattr(self, name))
+            for msgid, (layout, name) in MspParser.MESSAGES.items()}
+
+    def parse(self, data):
+        buf = self.buffer
+        buf += data
+        start = 0
+        while True:
+            start = buf.find(b'$M', start)
+            if start < 0:
+                # Keep a final $ that may begin the next header
+                start = len(buf) - (1 if buf.endswith(b'$') else 0)
+                break
+            if len(buf) - start < 6:
+                break
+            if buf[start+2] not in b'<>!':
+                start += 1
+                continue
+            size = buf[start+3]
+            end = start + 6 + size
+            if len(buf) < end:
+                break
+            self.message_direction = 1 if buf[start+2] == 62 else 0  # >
+            self.message_id = buf[start+4]
+            self.message_buffer = bytes(buf[start+5:end-1])
+            checksum = reduce(xor, self.message_buffer, size ^ self.message_id)
+            if checksum == buf[end-1]:
                 self.dispatchMessage()
+                start = end
             else:
                 print("code: " + str(self.message_id) + " - crc failed")
-            # Reset variables
-            self.message_length_received = 0
-            self.state = 0
-
-        else:
-            print("Unknown state detected: %d" % self.state)
+                start += 1
+        del buf[:start]
 
     @staticmethod
     def crc8(data):
@@ -82,35 +74,42 @@ class MspParser(metaclass=abc.ABCMeta):
         return crc
 
     def dispatchMessage(self):
+        entry = self.dispatch.get(self.message_id)
+        if entry is not None:
+            unpack, size, handler = entry
+            if len(self.message_buffer) == size:
+                handler(*unpack(self.message_buffer))
 
-        if self.message_id == 105:
-            self.handle_RC(*struct.unpack('=hhhhhh', self.message_buffer))
-
-        if self.message_id == 108:
-            self.handle_ATTITUDE(*struct.unpack('=hhh', self.message_buffer))
+    @abc.abstractmethod
+    def handle_RC(self, c1, c2, c3, c4, c5, c6):
+        return
 
-        if self.message_id == 121:
-            self.handle_VL53L5(*struct.unpack('=hhhhhhhhhhhhhhhh', self.message_buffer))
+    @abc.abstractmethod
+    def handle_ATTITUDE(self, angx, angy, heading):
+        return
 
-        if self.message_id == 122:
-            self.handle_PAA3905(*struct.unpack('=hh', self.message_buffer))
+    @abc.abstractmethod
+    def handle_VL53L5(self, p11, p12, p13, p14, p21, p22, p23, p24, p31, p32, p33, p34, p41, p42, p43, p44):
+        return
 
+    @abc.abstractmethod
+    def handle_PAA3905(self, x, y):
         return
 
     @abc.abstractmethod
-    def handle_RC(self, c1, c2, c3, c4, c5, c6):
+    def handle_BOOT_TIMES(self, start, running, gyro, esc, armable):
         return
 
     @abc.abstractmethod
-    def handle_ATTITUDE(self, angx, angy, heading):
+    def handle_GYRO_SPECTRUM(self, channel, rate, b00, b01, b02, b03, b04, b05, b06, b07, b08, b09, b10, b11, b12, b13, b14, b15, b16, b17, b18, b19, b20, b21, b22, b23, b24, b25, b26, b27, b28, b29, b30, b31):
         return
 
     @abc.abstractmethod
-    def handle_VL53L5(self, p11, p12, p13, p14, p21, p22, p23, p24, p31, p32, p33, p34, p41, p42, p43, p44):
+    def handle_PARAMETERS(self, angle_rate_p, angle_rate_i, angle_rate_d, angle_rate_f, angle_level_p, angle_rate_max, angle_rate_center, angle_yaw_lpf_hz, althold_p, althold_i, althold_alt_min, althold_pilot_velz_max, althold_stick_deadband, althold_windup_max, flowhold_p, flowhold_i, flowhold_pilot_vely_max, flowhold_stick_deadband, flowhold_windup_max):
         return
 
     @abc.abstractmethod
-    def handle_PAA3905(self, x, y):
+    def handle_LOOP_RATE(self, freq_hz, core_percent, headroom):
         return
 
     @staticmethod
@@ -133,6 +132,26 @@ class MspParser(metaclass=abc.ABCMeta):
         msg = '$M<' + chr(0) + chr(122) + chr(122)
         return bytes(msg, 'utf-8')
 
+    @staticmethod
+    def serialize_BOOT_TIMES_Request():
+        msg = '$M<' + chr(0) + chr(123) + chr(123)
+        return bytes(msg, 'utf-8')
+
+    @staticmethod
+    def serialize_GYRO_SPECTRUM_Request():
+        msg = '$M<' + chr(0) + chr(124) + chr(124)
+        return bytes(msg, 'utf-8')
+
+    @staticmethod
+    def serialize_PARAMETERS_Request():
+        msg = '$M<' + chr(0) + chr(125) + chr(125)
+        return bytes(msg, 'utf-8')
+
+    @staticmethod
+    def serialize_LOOP_RATE_Request():
+        msg = '$M<' + chr(0) + chr(126) + chr(126)
+        return bytes(msg, 'utf-8')
+
     @staticmethod
     def serialize_SET_RAW_RC(c1, c2, c3, c4, c5, c6):
         message_buffer = struct.pack('hhhhhh', c1, c2, c3, c4, c5, c6)
@@ -144,3 +163,15 @@ class MspParser(metaclass=abc.ABCMeta):
         message_buffer = struct.pack('hhhh', m1, m2, m3, m4)
         msg = [len(message_buffer), 214] + list(message_buffer)
         return bytes([ord('$'), ord('M'), ord('<')] + msg + [MspParser.crc8(msg)])
+
+    @staticmethod
+    def serialize_SET_PARAMETER(value, index):
+        message_buffer = struct.pack('fh', value, index)
+        msg = [len(message_buffer), 226] + list(message_buffer)
+        return bytes([ord('$'), ord('M'), ord('<')] + msg + [MspParser.crc8(msg)])
+
+    @staticmethod
+    def serialize_COMMIT_PARAMETERS(persist):
+        message_buffer = struct.pack('h', persist)
+        msg = [len(message_buffer), 227] + list(message_buffer)
+        return bytes([ord('$'), ord('M'), ord('<')] + msg + [MspParser.crc8(msg)])
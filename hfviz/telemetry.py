@@ -0,0 +1,42 @@
+'''
+This file is part of Hackflight.
+
+Hackflight is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Hackflight is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Hackflight. If not, see <https://www.gnu.org/licenses/>.
+'''
+
+
+class Telemetry(object):
+    '''
+    Latest value of each kind of telemetry.  The comms thread puts values as
+    messages arrive; the display tasks get them at their own frame rate,
+    along with a count that tells them whether anything new has arrived.
+    Only the comms thread puts, and each put replaces a whole tuple, so no
+    lock is needed.
+    '''
+
+    def __init__(self):
+
+        self.values = {}
+
+    def put(self, name, value):
+
+        _, count = self.values.get(name, (None, 0))
+
+        self.values[name] = value, count + 1
+
+    def get(self, name, default=None):
+        '''
+        Returns (value, count), or (default, 0) if nothing has arrived yet
+        '''
+
+        return self.values.get(name, (default, 0))
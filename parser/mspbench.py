@@ -0,0 +1,84 @@
+#!/usr/bin/python3
+'''
+Measures how many messages per second a generated Python parser can decode.
+
+Run it from a directory holding a generated mspparser.py, e.g.:
+
+    % cd ../hfviz
+    % python3 ../parser/mspbench.py
+
+Copyright (C) 2023 Simon D. Levy
+
+MIT License
+'''
+
+from argparse import ArgumentParser
+from os import getcwd
+from random import Random
+from time import perf_counter
+import sys
+
+sys.path.insert(0, getcwd())
+
+from mspparser import MspParser  # noqa: E402
+
+
+def _handle(self, *args):
+    self.count += 1
+
+
+# Handles every message by counting it
+CountingParser = type('CountingParser', (MspParser,), dict(
+    {name: _handle for _, name in MspParser.MESSAGES.values()}, count=0))
+
+
+def make_stream(count, seed):
+    '''Builds a stream of reply frames cycling through all message types'''
+
+    rng = Random(seed)
+    ids = sorted(MspParser.MESSAGES)
+    frames = bytearray()
+
+    for k in range(count):
+        msgid = ids[k % len(ids)]
+        layout, _ = MspParser.MESSAGES[msgid]
+        payload = bytes(rng.randrange(256) for _ in range(layout.size))
+        msg = [layout.size, msgid] + list(payload)
+        frames += bytes([ord('$'), ord('M'), ord('>')] + msg +
+                        [MspParser.crc8(msg)])
+
+    return bytes(frames)
+
+
+def run(stream, chunk):
+
+    parser = CountingParser()
+
+    start = perf_counter()
+    for k in range(0, len(stream), chunk):
+        parser.parse(stream[k:k+chunk])
+    elapsed = perf_counter() - start
+
+    return parser.count, elapsed
+
+
+def main():
+
+    argparser = ArgumentParser()
+
+    argparser.add_argument('-n', '--count', type=int, default=100000,
+                           help='number of messages')
+    argparser.add_argument('-c', '--chunk', type=int, default=4096,
+                           help='bytes per read')
+
+    args = argparser.parse_args()
+
+    stream = make_stream(args.count, 0)
+
+    for chunk in (1, args.chunk):
+        count, elapsed = run(stream, chunk)
+        print('%5d bytes/read: %7d messages in %6.3f sec = %9.0f msg/sec' %
+              (chunk, count, elapsed, count / elapsed))
+
+
+main()
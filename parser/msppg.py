@@ -102,62 +102,73 @@ class Python_Emitter(CodeEmitter):
         self.output.write('\n\n#  Gnu Public License')
         self._write('\n\nimport struct')
         self._write('\n\nimport abc')
+        self._write('\n\nfrom functools import reduce')
+        self._write('\nfrom operator import xor')
         self._write('\n\n\nclass MspParser(metaclass=abc.ABCMeta):')
 
+        # Emit table of payload layouts and handler names, so that payloads
+        # are decoded by precompiled structs and dispatched through a dict
+        self._write('\n\n    # Messages from the flight controller: ID => ' +
+                    '(payload layout, handler)')
+        self._write('\n    MESSAGES = {')
+        for msgtype in self.msgdict.keys():
+            msgstuff = self.msgdict[msgtype]
+            msgid = msgstuff[0]
+            if msgid < 200:
+                self._write('\n        %d: (struct.Struct(\'=' % msgid)
+                for argtype in self._getargtypes(msgstuff):
+                    self._write('%s' % self.typedict[argtype])
+                self._write('\'), \'handle_%s\'),' % msgtype)
+        self._write('\n    }')
+
         # Emit __init__() method
         self._write('\n\n    def __init__(self):')
-        self._write('\n        self.state = 0')
-
-        # Emit parse() method
-        self._write('\n\n    def parse(self, char):')
-        self._write('\n        byte = ord(char)\n')
-        self._write('\n        if self.state == 0:  # sync char 1')
-        self._write('\n            if byte == 36:  # $')
-        self._write('\n                self.state += 1\n')
-        self._write('\n        elif self.state == 1:  # sync char 2')
-        self._write('\n            if byte == 77:  # M')
-        self._write('\n                self.state += 1')
-        self._write('\n            else:  # restart and try again')
-        self._write('\n                self.state = 0\n')
-        self._write('\n        elif self.state == 2:  # direction')
-        self._write('\n            if byte == 62:  # >')
-        self._write('\n                self.message_direction = 1')
-        self._write('\n            else:  # <')
-        self._write('\n                self.message_direction = 0')
-        self._write('\n            self.state += 1\n')
-        self._write('\n        elif self.state == 3:')
-        self._write('\n            self.message_length_expected = byte')
-        self._write('\n            self.message_checksum = byte')
-        self._write('\n            # setup arraybuffer')
-        self._write('\n            self.message_buffer = b""')
-        self._write('\n            self.state += 1\n')
-        self._write('\n        elif self.state == 4:')
-        self._write('\n            self.message_id = byte')
-        self._write('\n            self.message_length_received = 0')
-        self._write('\n            self.message_checksum ^= byte')
-        self._write('\n            if self.message_length_expected > 0:')
-        self._write('\n                # process payload')
-        self._write('\n                self.state += 1')
-        self._write('\n            else:')
-        self._write('\n                # no payload')
-        self._write('\n                self.state += 2\n')
-        self._write('\n        elif self.state == 5:  # payload')
-        self._write('\n            self.message_buffer += char')
-        self._write('\n            self.message_checksum ^= byte')
-        self._write('\n            self.message_length_received += 1')
-        self._write('\n            if self.message_length_received >= self.message_length_expected:')
-        self._write('\n                self.state += 1\n')
-        self._write('\n        elif self.state == 6:')
-        self._write('\n            if self.message_checksum == byte:')
-        self._write('\n                # message received, process')
+        self._write('\n        self.buffer = bytearray()')
+        self._write('\n        # ID => (decoder, payload size, bound handler)')
+        self._write('\n        self.dispatch = {')
+        self._write('\n            msgid: (layout.unpack, layout.size, ' +
+                    'getattr(self, name))')
+        self._write('\n            for msgid, (layout, name) in ' +
+                    'MspParser.MESSAGES.items()}')
+
+        # Emit parse() method: scans the buffered bytes for each $M header
+        # and takes whole frames, so it can be fed any number of bytes
+        self._write('\n\n    def parse(self, data):')
+        self._write('\n        buf = self.buffer')
+        self._write('\n        buf += data')
+        self._write('\n        start = 0')
+        self._write('\n        while True:')
+        self._write('\n            start = buf.find(b\'$M\', start)')
+        self._write('\n            if start < 0:')
+        self._write('\n                # Keep a final $ that may begin ' +
+                    'the next header')
+        self._write('\n                start = len(buf) - ' +
+                    '(1 if buf.endswith(b\'$\') else 0)')
+        self._write('\n                break')
+        self._write('\n            if len(buf) - start < 6:')
+        self._write('\n                break')
+        self._write('\n            if buf[start+2] not in b\'<>!\':')
+        self._write('\n                start += 1')
+        self._write('\n                continue')
+        self._write('\n            size = buf[start+3]')
+        self._write('\n            end = start + 6 + size')
+        self._write('\n            if len(buf) < end:')
+        self._write('\n                break')
+        self._write('\n            self.message_direction = ' +
+                    '1 if buf[start+2] == 62 else 0  # >')
+        self._write('\n            self.message_id = buf[start+4]')
+        self._write('\n            self.message_buffer = ' +
+                    'bytes(buf[start+5:end-1])')
+        self._write('\n            checksum = reduce(xor, ' +
+                    'self.message_buffer, size ^ self.message_id)')
+        self._write('\n            if checksum == buf[end-1]:')
         self._write('\n                self.dispatchMessage()')
+        self._write('\n                start = end')
         self._write('\n            else:')
-        self._write('\n                print("code: " + str(self.message_id) + " - crc failed")')
-        self._write('\n            # Reset variables')
-        self._write('\n            self.message_length_received = 0')
-        self._write('\n            self.state = 0\n')
-        self._write('\n        else:')
-        self._write('\n            print("Unknown state detected: %d" % self.state)')
+        self._write('\n                print("code: " + str(self.message_id) ' +
+                    '+ " - crc failed")')
+        self._write('\n                start += 1')
+        self._write('\n        del buf[:start]')
 
         # Emit crc8() method
         self._write('\n\n    @staticmethod')
@@ -167,20 +178,13 @@ class Python_Emitter(CodeEmitter):
         self._write('\n            crc ^= c')
         self._write('\n        return crc')
 
-        # Emit dispatchMeessage() method
+        # Emit dispatchMessage() method
         self._write('\n\n    def dispatchMessage(self):')
-        for msgtype in self.msgdict.keys():
-            msgstuff = self.msgdict[msgtype]
-            msgid = msgstuff[0]
-            if msgid < 200:
-                self._write('\n\n        if self.message_id == %d:\n'
-                            % msgstuff[0])
-                self._write('            self.handle_%s(*struct.unpack(\'=' %
-                            msgtype)
-                for argtype in self._getargtypes(msgstuff):
-                    self._write('%s' % self.typedict[argtype])
-                self._write("\'" + ', self.message_buffer))')
-        self._write('\n\n        return')
+        self._write('\n        entry = self.dispatch.get(self.message_id)')
+        self._write('\n        if entry is not None:')
+        self._write('\n            unpack, size, handler = entry')
+        self._write('\n            if len(self.message_buffer) == size:')
+        self._write('\n                handler(*unpack(self.message_buffer))')
 
         # Emit handler methods for parser
         for msgtype in self.msgdict.keys():
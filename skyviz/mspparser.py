@@ -10,69 +10,45 @@ import struct
 
 import abc
 
+from functools import reduce
+from operator import xor
+
 
 class MspParser(metaclass=abc.ABCMeta):
 
     def __init__(self):
-        self.state = 0
-
-    def parse(self, char):
-        byte = ord(char)
-
-        if self.state == 0:  # sync char 1
-            if byte == 36:  # $
-                self.state += 1
-
-        elif self.state == 1:  # sync char 2
-            if byte == 77:  # M
-                self.state += 1
-            else:  # restart and try again
-                self.state = 0
-
-        elif self.state == 2:  # direction
-            if byte == 62:  # >
-                self.message_direction = 1
-            else:  # <
-                self.message_direction = 0
-            self.state += 1
-
-        elif self.state == 3:
-            self.message_length_expected = byte
-            self.message_checksum = byte
-            # setup arraybuffer
-            self.message_buffer = b""
-            self.state += 1
-
-        elif self.state == 4:
-            self.message_id = byte
-            self.message_length_received = 0
-            self.message_checksum ^= byte
-            if self.message_length_expected > 0:
-                # process payload
-                self.state += 1
-            else:
-                # no payload
-                self.state += 2
-
-        elif self.state == 5:  # payload
-            self.message_buffer += char
-            self.message_checksum ^= byte
-            self.message_length_received += 1
-            if self.message_length_received >= self.message_length_expected:
-                self.state += 1
-
-        elif self.state == 6:
-            if self.message_checksum == byte:
-                # message received, process
+        self.buffer = bytearray()
+
+    def parse(self, data):
+        buf = self.buffer
+        buf += data
+        start = 0
+        while True:
+            start = buf.find(b'$M', start)
+            if start < 0:
+                # Keep a final $ that may begin the next header
+                start = len(buf) - (1 if buf.endswith(b'$') else 0)
+                break
+            if len(buf) - start < 6:
+                break
+            if buf[start+2] not in b'<>!':
+                start += 1
+                continue
+            size = buf[start+3]
+            end = start + 6 + size
+            if len(buf) < end:
+                break
+            self.message_direction = 1 if buf[start+2] == 62 else 0  # >
+            self.message_id = buf[start+4]
+            self.message_buffer = bytes(buf[start+5:end-1])
+            checksum = reduce(xor, self.message_buffer, size ^ self.message_id)
+            if checksum == buf[end-1]:
                 self.dispatchMessage()
+                start = end
             else:
                 print("code: " + str(self.message_id) + " - crc failed")
-            # Reset variables
-            self.message_length_received = 0
-            self.state = 0
-
-        else:
-            print("Unknown state detected: %d" % self.state)
+                start += 1
+        del buf[:start]
 
 
     @abc.abstractmethod
@@ -2,26 +2,30 @@
 
 from argparse import ArgumentParser
 from serial import Serial
-from struct import unpack
+from struct import Struct
 
 from mspparser import MspParser
 
 
 class SkyParser(MspParser):
 
+    # Message ID => (label, payload layout)
+    MESSAGES = {
+        213: ('attitude:', Struct('=hhh')),              # Attitude
+        221: ('ranger:  ', Struct('=hhhhhhhhhhhhhhhh')), # VL53L5 ranging camera
+        222: ('mocap:   ', Struct('=hh')),               # PAA3905 mocap
+    }
+
     def dispatchMessage(self):
 
-        # Attitude
-        if self.message_id == 213:
-            print('attitude:', *unpack('=hhh', self.message_buffer))
+        message = self.MESSAGES.get(self.message_id)
+
+        if message is not None:
 
-        # VL53L5 ranging camera
-        if self.message_id == 221:
-            print('ranger:  ', *unpack('=hhhhhhhhhhhhhhhh', self.message_buffer))
+            label, layout = message
 
-        # PAA3905 mocap
-        if self.message_id == 222:
-            print('mocap:   ', *unpack('=hh', self.message_buffer))
+            if len(self.message_buffer) == layout.size:
+                print(label, *layout.unpack(self.message_buffer))
 
 
 def main():
@@ -42,7 +46,8 @@ def main():
 
         try:
 
-            skyparser.parse(port.read(1))
+            # Block for at least one byte, then take whatever has arrived
+            skyparser.parse(port.read(port.in_waiting or 1))
 
         except KeyboardInterrupt:
 
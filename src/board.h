@@ -17,6 +17,7 @@
 #pragma once
 
 #include "core/mixer.h"
+#include "core/sections.h"
 #include "logic.h"
 #include "esc.h"
 
@@ -26,11 +27,21 @@ class Stm32Board {
 
     private:
 
+        // Rapid LED flashing at startup
+        static const uint32_t LED_STARTUP_MSEC = 500;
+        static const uint32_t LED_STARTUP_PERIOD_MSEC = 50;
+
         uint8_t m_ledPin;
         bool m_ledInverted;
 
+        uint32_t m_beginMsec;
+
         uint8_t m_imuInterruptPin;
 
+        // MSP transport: USB serial unless the sketch gives another stream,
+        // such as a UART to a WiFi bridge
+        Stream * m_mspStream;
+
         Logic m_logic;
 
         void runDynamicTasks(Imu & imu, const int16_t rawAccel[3])
@@ -74,6 +85,7 @@ class Stm32Board {
                     break;
 
                 case Task::SKYRANGER:
+                case Task::SPECTRUM:
                     runTask(imu, prioritizer.id);
                     break;
 
@@ -107,6 +119,12 @@ class Stm32Board {
 
         void updateLed(void)
         {
+            // Flash at startup without holding up begin()
+            if (millis() - m_beginMsec < LED_STARTUP_MSEC) {
+                ledBlink(LED_STARTUP_PERIOD_MSEC);
+                return;
+            }
+
             switch (m_logic.getArmingStatus()) {
 
                 case Logic::ARMING_UNREADY:
@@ -161,12 +179,16 @@ class Stm32Board {
 
                 const auto usec = micros();
 
-                while (Serial.available()) {
+                while (m_mspStream->available()) {
+
+                    if (m_logic.mspParse(m_mspStream->read())) {
 
-                    if (m_logic.mspParse(Serial.read())) {
-                        while (m_logic.mspAvailable()) {
-                            Serial.write(m_logic.mspRead());
-                        }
+                        // One write per reply, so a packet transport sends
+                        // each in a single datagram
+                        uint8_t reply[Msp::BUF_SIZE] = {};
+
+                        m_mspStream->write(
+                                reply, m_logic.mspRead(reply, sizeof(reply)));
                     }
                 }
 
@@ -202,6 +224,8 @@ class Stm32Board {
             // Support negative LED pin number for inversion
             m_ledPin = ledPin < 0 ? -ledPin : ledPin;
             m_ledInverted = ledPin < 0;
+
+            m_mspStream = &Serial;
         }
 
         virtual void prioritizeExtraTasks(
@@ -220,6 +244,12 @@ class Stm32Board {
             (void)serial;
         }
 
+        // For boards with a barometer
+        void updateBarometer(const float mbar)
+        {
+            m_logic.updateBarometer(mbar);
+        }
+
     public:
 
         void setSbusValues(uint16_t chanvals[], const uint32_t usec, const bool lostFrame)
@@ -232,6 +262,11 @@ class Stm32Board {
             m_logic.setDsmxValues(chanvals, usec, lostFrame);
         }
 
+        void setMspStream(Stream & stream)
+        {
+            m_mspStream = &stream;
+        }
+
         void handleImuInterrupt(Imu & imu)
         {
             m_logic.handleImuInterrupt(imu, getCycleCounter());
@@ -247,21 +282,21 @@ class Stm32Board {
             return DWT->CYCCNT;
         }
 
-        void begin(Imu & imu, const uint8_t imuInterruptPin, void (*irq)(void))
+        // Parameters are loaded from storage when one is given
+        void begin(
+                Imu & imu,
+                const uint8_t imuInterruptPin,
+                void (*irq)(void),
+                Storage * storage=NULL)
         {
             startCycleCounter();
 
-            m_logic.begin(imu, getClockSpeed());
+            m_beginMsec = millis();
+
+            m_logic.begin(imu, getClockSpeed(), m_beginMsec, storage);
 
             pinMode(m_ledPin, OUTPUT);
 
-            ledSet(false);
-            for (auto i=0; i<10; i++) {
-                static bool ledOn;
-                ledOn = !ledOn;
-                ledSet(ledOn);
-                delay(50);
-            }
             ledSet(false);
 
             pinMode(imuInterruptPin, INPUT);
@@ -271,9 +306,9 @@ class Stm32Board {
             m_imuInterruptPin = imuInterruptPin;
         }
 
-        void step(
+        FAST_CODE void step(
                 Imu & imu,
-                std::vector<PidController *> pids,
+                PidController::list_t & pids,
                 Mixer & mixer,
                 Esc & esc,
                 int16_t rawGyro[3],
@@ -297,16 +332,81 @@ class Stm32Board {
 
                 float mixmotors[Mixer::MAX_MOTORS] = {};
 
-                // Wait a little for DSHOT ESCs to start up
-                if (esc.isReady(usec)) {
-                    m_logic.step(imu, pids, mixer, rawGyro, usec, mixmotors);
-                }
+                // Keep running the core (and so calibrating the gyro) while
+                // DSHOT ESCs start up; arming waits until they're ready
+                m_logic.setEscReady(esc.isReady(usec));
+
+                const auto coreStartCycles = getCycleCounter();
+
+                m_logic.step(imu, pids, mixer, rawGyro, usec, mixmotors);
 
                 esc.write(
                         m_logic.getArmingStatus() == Logic::ARMING_ARMED ?
                         mixmotors :
                         m_logic.getVisualizerMotors());
 
+                // Time the core path at boot to choose the loop rate
+                if (m_logic.isLoopRateCalibrating()) {
+                    m_logic.updateLoopRate(
+                            imu, pids, getCycleCounter() - coreStartCycles);
+                }
+
+                m_logic.updateScheduler(imu, nowCycles, nextTargetCycles);
+            }
+
+            if (m_logic.isDynamicTaskReady(getCycleCounter())) {
+                runDynamicTasks(imu, rawAccel);
+            }
+        }
+
+        // Static-dispatch version of step(): the concrete IMU, ESC and PID
+        // controller types are template parameters, so their virtual methods
+        // are called by qualified name and can be inlined into the core loop.
+        template <class ImuT, class EscT, class... PidT>
+        FAST_CODE void step(
+                ImuT & imu,
+                Mixer & mixer,
+                EscT & esc,
+                int16_t rawGyro[3],
+                int16_t rawAccel[3],
+                PidT & ... pids)
+        {
+            auto nowCycles = getCycleCounter();
+
+            if (m_logic.isCoreTaskReady(nowCycles)) {
+
+                const uint32_t usec = micros();
+
+                int32_t loopRemainingCycles = 0;
+
+                const uint32_t nextTargetCycles =
+                    m_logic.coreTaskPreUpdate(loopRemainingCycles);
+
+                while (loopRemainingCycles > 0) {
+                    nowCycles = getCycleCounter();
+                    loopRemainingCycles = intcmp(nextTargetCycles, nowCycles);
+                }
+
+                float mixmotors[Mixer::MAX_MOTORS] = {};
+
+                // Keep running the core (and so calibrating the gyro) while
+                // DSHOT ESCs start up; arming waits until they're ready
+                m_logic.setEscReady(esc.EscT::isReady(usec));
+
+                const auto coreStartCycles = getCycleCounter();
+
+                m_logic.step(imu, mixer, rawGyro, usec, mixmotors, pids...);
+
+                esc.EscT::write(
+                        m_logic.getArmingStatus() == Logic::ARMING_ARMED ?
+                        mixmotors :
+                        m_logic.getVisualizerMotors());
+
+                if (m_logic.isLoopRateCalibrating()) {
+                    m_logic.updateLoopRate(
+                            imu, getCycleCounter() - coreStartCycles, pids...);
+                }
+
                 m_logic.updateScheduler(imu, nowCycles, nextTargetCycles);
             }
 
@@ -317,7 +417,7 @@ class Stm32Board {
 
         void step(
                 Imu & imu,
-                std::vector<PidController *> pids,
+                PidController::list_t & pids,
                 Mixer & mixer,
                 Esc & esc,
                 int16_t rawGyro[3],
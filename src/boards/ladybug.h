@@ -42,21 +42,165 @@ class LadybugBoard : public Stm32Board {
 
         static const uint8_t IMU_INTERRUPT_PIN = 0x0C;
 
+        // EM7180 registers for checking whether the Sentral already has its
+        // firmware loaded from EEPROM (at power-on, or before a soft reboot)
+        static const uint8_t SENTRAL_ADDRESS     = 0x28;
+        static const uint8_t SENTRAL_STATUS      = 0x37;
+        static const uint8_t SENTRAL_RAM_VERSION = 0x72;
+
+        static const uint8_t STATUS_UPLOAD_DONE  = 0x02;
+        static const uint8_t STATUS_UPLOAD_ERROR = 0x04;
+
+        // Barometer result: its bit in the event status and interrupt
+        // enable registers, and the pressure register (signed 16 bits,
+        // 0.01 mbar from 1013.25)
+        static const uint8_t EVENT_BAROMETER = 0x40;
+        static const uint8_t SENTRAL_BARO    = 0x2A;
+
+        static const uint32_t FIRMWARE_WAIT_MSEC = 100;
+
+        // RAM version (SENTRAL_RAM_VERSION, little-endian) of the image that
+        // Usfs::loadFirmware() uploads.  A sketch can define
+        // USFS_FIRMWARE_RAM_VERSION before including Hackflight headers (or
+        // a build can pass it with -D) to skip the upload when the Sentral
+        // already runs that image; otherwise it is uploaded on every boot.
+#if defined(USFS_FIRMWARE_RAM_VERSION)
+        static const uint16_t FIRMWARE_RAM_VERSION = USFS_FIRMWARE_RAM_VERSION;
+#else
+        static const uint16_t FIRMWARE_RAM_VERSION = 0;
+#endif
+
         static const uint8_t INTERRUPT_ENABLE = Usfs::INTERRUPT_RESET_REQUIRED |
             Usfs::INTERRUPT_ERROR |
             Usfs::INTERRUPT_GYRO | 
-            Usfs::INTERRUPT_QUAT;
-
-        std::vector<uint8_t> MOTOR_PINS = {0x0D, 0x10, 0x03, 0x0B};
+            Usfs::INTERRUPT_QUAT |
+            EVENT_BAROMETER;
 
         Usfs m_usfs;
 
         LadybugImu m_imu; 
 
-        BrushedEsc m_esc = BrushedEsc(&MOTOR_PINS);
+        BrushedEsc m_esc = BrushedEsc({0x0D, 0x10, 0x03, 0x0B});
 
+        int16_t m_rawGyro[3] = {};
         int16_t m_rawAccel[3] = {};
 
+        // Reads consecutive registers in one transaction, so that a
+        // multi-byte value can't change partway through
+        static bool readSentralRegisters(
+                const uint8_t reg, uint8_t bytes[], const uint8_t count)
+        {
+            Wire.beginTransmission(SENTRAL_ADDRESS);
+            Wire.write(reg);
+            Wire.endTransmission(false);
+
+            if (Wire.requestFrom(SENTRAL_ADDRESS, count) != count) {
+                return false;
+            }
+
+            for (uint8_t k=0; k<count; ++k) {
+                bytes[k] = Wire.read();
+            }
+
+            return true;
+        }
+
+        static uint8_t readSentralRegister(const uint8_t reg)
+        {
+            uint8_t value = 0;
+
+            return readSentralRegisters(reg, &value, 1) ? value : 0;
+        }
+
+        // Pressure in mbar, read in one burst
+        static bool readSentralPressure(float & mbar)
+        {
+            uint8_t bytes[2] = {};
+
+            if (!readSentralRegisters(SENTRAL_BARO, bytes, 2)) {
+                return false;
+            }
+
+            mbar = (int16_t)(bytes[1] << 8 | bytes[0]) * 0.01f + 1013.25f;
+
+            return true;
+        }
+
+        // Waits briefly for the Sentral's own EEPROM upload, and reports
+        // whether it (or the upload before a soft reboot) left the image
+        // that Usfs::loadFirmware() would upload
+        static bool firmwareIsLoaded(void)
+        {
+            if (FIRMWARE_RAM_VERSION == 0) {
+                return false;
+            }
+
+            const auto start = millis();
+
+            while (millis() - start < FIRMWARE_WAIT_MSEC) {
+
+                const auto status = readSentralRegister(SENTRAL_STATUS);
+
+                if (status & STATUS_UPLOAD_ERROR) {
+                    return false;
+                }
+
+                if (status & STATUS_UPLOAD_DONE) {
+
+                    uint8_t version[2] = {};
+
+                    return
+                        readSentralRegisters(SENTRAL_RAM_VERSION, version, 2) &&
+                        (version[1] << 8 | version[0]) == FIRMWARE_RAM_VERSION;
+                }
+
+                delay(1);
+            }
+
+            return false;
+        }
+
+        void readImu(void)
+        {
+            if (m_imu.gotNewData) { 
+
+                m_imu.gotNewData = false;  
+
+                uint8_t eventStatus = Usfs::checkStatus(); 
+
+                if (Usfs::eventStatusIsError(eventStatus)) { 
+                    Usfs::reportError(eventStatus);
+                }
+
+                if (Usfs::eventStatusIsGyrometer(eventStatus)) { 
+                    m_usfs.readGyrometerRaw(m_rawGyro);
+                }
+
+                if (Usfs::eventStatusIsQuaternion(eventStatus)) { 
+                    m_usfs.readQuaternion(m_imu.qw, m_imu.qx, m_imu.qy, m_imu.qz);
+                }
+
+                float mbar = 0;
+
+                if ((eventStatus & EVENT_BAROMETER) &&
+                        readSentralPressure(mbar)) { 
+                    updateBarometer(mbar);
+                }
+            }
+        }
+
+    protected:
+
+        // The accelerometer task runs the altitude estimator, which the
+        // barometer feeds
+        virtual void prioritizeExtraTasks(
+                Logic & logic,
+                Task::prioritizer_t & prioritizer,
+                const uint32_t usec) override
+        {
+            logic.prioritizeAccelerometerTask(prioritizer, usec);
+        }
+
     public:
 
         static const uint8_t LED_PIN = 0x12;
@@ -72,11 +216,12 @@ class LadybugBoard : public Stm32Board {
 
             Wire.begin();
             Wire.setClock(400000); 
-            delay(100);
 
             Stm32Board::begin(m_imu, IMU_INTERRUPT_PIN, isr);  
 
-            m_usfs.loadFirmware(); 
+            if (!firmwareIsLoaded()) {
+                m_usfs.loadFirmware(); 
+            }
 
             m_usfs.begin(
                     ACCEL_BANDWIDTH,
@@ -95,30 +240,21 @@ class LadybugBoard : public Stm32Board {
             m_esc.begin();
         }
 
-        void step(std::vector<PidController *> pids, Mixer & mixer)
+        void step(PidController::list_t & pids, Mixer & mixer)
         {
-            static int16_t rawGyro[3];
-
-            if (m_imu.gotNewData) { 
-
-                m_imu.gotNewData = false;  
-
-                uint8_t eventStatus = Usfs::checkStatus(); 
-
-                if (Usfs::eventStatusIsError(eventStatus)) { 
-                    Usfs::reportError(eventStatus);
-                }
+            readImu();
 
-                if (Usfs::eventStatusIsGyrometer(eventStatus)) { 
-                    m_usfs.readGyrometerRaw(rawGyro);
-                }
+            Stm32Board::step(m_imu, pids, mixer, m_esc, m_rawGyro, m_rawAccel);
+        }
 
-                if (Usfs::eventStatusIsQuaternion(eventStatus)) { 
-                    m_usfs.readQuaternion(m_imu.qw, m_imu.qx, m_imu.qy, m_imu.qz);
-                }
-            } 
+        // Static-dispatch version: IMU and ESC types are fixed by this
+        // board, and PID controller types are deduced
+        template <class... PidT>
+        void step(Mixer & mixer, PidT & ... pids)
+        {
+            readImu();
 
-            Stm32Board::step(m_imu, pids, mixer, m_esc, rawGyro, m_rawAccel);
+            Stm32Board::step(m_imu, mixer, m_esc, m_rawGyro, m_rawAccel, pids...);
         }
 
         void handleImuInterrupt(void)
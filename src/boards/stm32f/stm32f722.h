@@ -18,15 +18,13 @@
 
 #include "board/stm32f.h"
 
-#include <vector>
-
 class Stm32F722Board : public Stm32FBoard {
 
     public:
 
         Stm32F722Board(
                 SoftQuatImu & imu,
-                std::vector<PidController *> & pids,
+                PidController::list_t & pids,
                 Mixer & mixer,
                 Esc & esc,
                 const uint8_t ledPin)
@@ -0,0 +1,209 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+
+#include "core/axes.h"
+#include "core/vstate.h"
+
+// Altitude (m, up) and vertical velocity (m/sec) for altitude hold.  A
+// third-order complementary filter: vertical acceleration, from the
+// accelerometer and the attitude quaternion, is integrated at the
+// accelerometer rate, and each rangefinder or barometer reading pulls
+// altitude, velocity, and an accelerometer bias toward it.  The gains put
+// all three poles at -1/tau, so the rangefinder (tau RANGE_TAU) is trusted
+// more than the barometer (tau BARO_TAU).
+//
+// The barometer has no notion of ground, so its altitude is taken relative
+// to an offset: the first reading, and afterward whatever keeps it in
+// agreement with the estimate while the rangefinder is in view.  Without
+// an accelerometer the prediction holds velocity constant and the bias
+// term takes up the acceleration.
+class AltitudeEstimator {
+
+    private:
+
+        static constexpr float GRAVITY = 9.80665;
+
+        static constexpr float RANGE_TAU = 0.5;   // sec
+        static constexpr float BARO_TAU  = 2.0;
+
+        // Readings beyond these are ignored
+        static constexpr float RANGE_MAX     = 4.0;   // m
+        static constexpr float RANGE_MIN_COS = 0.8;   // about 37 deg tilt
+
+        // The rangefinder counts as in view for this long after a reading
+        static constexpr float RANGE_TIMEOUT = 0.25;  // sec
+
+        // Longest interval credited to one reading, so that a gap doesn't
+        // turn into a kick
+        static constexpr float MAX_INTERVAL = 0.1;  // sec
+
+        // Time constant for tracking the barometer offset
+        static constexpr float BARO_OFFSET_TAU = 5.0;  // sec
+
+        class Sensor {
+
+            public:
+
+                float tau;
+                bool  pending;
+                float value;
+                float time;  // of the last reading applied
+
+                Sensor(const float _tau)
+                {
+                    tau = _tau;
+                    pending = false;
+                    value = 0;
+                    time = -1;
+                }
+        };
+
+        float m_z;
+        float m_dz;
+        float m_bias;   // m/sec^2
+
+        // Accumulated accelerometer-update time, sec
+        float m_time;
+
+        Sensor m_range = Sensor(RANGE_TAU);
+        Sensor m_baro  = Sensor(BARO_TAU);
+
+        bool  m_haveBaroOffset;
+        float m_baroOffset;
+
+        void correct(Sensor & sensor, const float measured)
+        {
+            const auto interval = sensor.time < 0 ?
+                MAX_INTERVAL : fminf(m_time - sensor.time, MAX_INTERVAL);
+
+            sensor.time = m_time;
+
+            const auto error = measured - m_z;
+
+            const auto k = interval / sensor.tau;
+
+            m_z    += 3 * k * error;
+            m_dz   += 3 * k / sensor.tau * error;
+            m_bias -= k / (sensor.tau * sensor.tau) * error;
+        }
+
+        bool rangeInView(void) const
+        {
+            return m_range.time >= 0 && m_time - m_range.time < RANGE_TIMEOUT;
+        }
+
+    public:
+
+        AltitudeEstimator(void)
+        {
+            m_z = 0;
+            m_dz = 0;
+            m_bias = 0;
+            m_time = 0;
+            m_haveBaroOffset = false;
+            m_baroOffset = 0;
+        }
+
+        // Called at the accelerometer rate, with the accelerometer (g,
+        // vehicle frame) when there is one, and the latest attitude
+        void update(
+                const float dt,
+                const VehicleState & vstate,
+                const Axes * accel=nullptr)
+        {
+            m_time += dt;
+
+            // Up in the body frame is the third row of the rotation
+            // matrix, as in VehicleState::rollTilt() and pitchTilt()
+            const auto accelUp = accel == nullptr ? 0 :
+                (vstate.pitchTilt() * accel->x +
+                 vstate.rollTilt() * accel->y +
+                 vstate.cosTilt() * accel->z - 1) * GRAVITY;
+
+            const auto ddz = accelUp - m_bias;
+
+            m_z  += (m_dz + ddz * dt / 2) * dt;
+            m_dz += ddz * dt;
+
+            if (m_range.pending) {
+                m_range.pending = false;
+                correct(m_range, m_range.value);
+            }
+
+            if (m_baro.pending) {
+
+                m_baro.pending = false;
+
+                if (!m_haveBaroOffset) {
+                    m_baroOffset = m_baro.value - m_z;
+                    m_haveBaroOffset = true;
+                }
+
+                // With the rangefinder in view, the barometer only follows
+                if (rangeInView()) {
+                    const auto interval = m_baro.time < 0 ?
+                        MAX_INTERVAL :
+                        fminf(m_time - m_baro.time, MAX_INTERVAL);
+                    m_baro.time = m_time;
+                    m_baroOffset += interval / BARO_OFFSET_TAU *
+                        (m_baro.value - m_z - m_baroOffset);
+                }
+
+                else {
+                    correct(m_baro, m_baro.value - m_baroOffset);
+                }
+            }
+        }
+
+        // Distance (m) along the body's down axis; applied at the next
+        // update
+        void setRange(const float range, const VehicleState & vstate)
+        {
+            const auto cos = vstate.cosTilt();
+
+            if (range > 0 && range < RANGE_MAX && cos > RANGE_MIN_COS) {
+                m_range.value = range * cos;
+                m_range.pending = true;
+            }
+        }
+
+        // Pressure altitude (m); applied at the next update
+        void setBaroAltitude(const float altitude)
+        {
+            m_baro.value = altitude;
+            m_baro.pending = true;
+        }
+
+        void get(VehicleState & vstate) const
+        {
+            vstate.z = m_z;
+            vstate.dz = m_dz;
+        }
+
+        // International Standard Atmosphere, troposphere
+        static float pressureToAltitude(const float mbar)
+        {
+            return 44330 * (1 - powf(mbar / 1013.25f, 0.190295f));
+        }
+
+}; // class AltitudeEstimator
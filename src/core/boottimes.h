@@ -0,0 +1,71 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Milliseconds from power-on to each stage of startup, reported to the
+// visualizer on request.  Zero means the stage hasn't been reached yet.
+class BootTimes {
+
+    public:
+
+        typedef enum {
+
+            START,      // board begin()
+            RUNNING,    // scheduler running tasks
+            GYRO,       // gyro calibrated
+            ESC,        // ESCs started up
+            ARMABLE,    // first ready-to-arm
+
+            COUNT
+
+        } phase_e;
+
+    private:
+
+        int16_t m_msec[COUNT];
+
+    public:
+
+        BootTimes(void)
+        {
+            for (uint8_t k=0; k<COUNT; ++k) {
+                m_msec[k] = 0;
+            }
+        }
+
+        // Keeps the first time reported for each phase
+        void mark(const phase_e phase, const uint32_t msec)
+        {
+            if (m_msec[phase] == 0) {
+                m_msec[phase] =
+                    msec > INT16_MAX ? INT16_MAX :
+                    msec == 0 ? 1 :
+                    (int16_t)msec;
+            }
+        }
+
+        const int16_t * get(void)
+        {
+            return m_msec;
+        }
+
+}; // class BootTimes
@@ -30,6 +30,11 @@ static inline uint16_t constrain_u16(const uint16_t amt, const uint16_t low, con
     return amt < low ? low : amt > high ? high : amt;
 }
 
+static inline int32_t constrain_i32(const int32_t amt, const int32_t low, const int32_t high)
+{
+    return amt < low ? low : amt > high ? high : amt;
+}
+
 static inline int32_t constrain_f_i32(const float amt, const int32_t low, const int32_t high)
 {
     return amt < low ? low : amt > high ? high : amt;
@@ -0,0 +1,151 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+// Radix-2 FFT of a real, Hann-windowed block of N samples, run one step at a
+// time so a low-priority task can spread it over several scheduler slots.
+// A step is either loading the block, one butterfly stage (N/2 butterflies),
+// or computing the magnitudes, so no step costs more than O(N).
+template <uint8_t LOG2N>
+class IncrementalFft {
+
+    public:
+
+        static const uint16_t N = 1 << LOG2N;
+
+        static const uint16_t BINS = N / 2;
+
+    private:
+
+        float m_window[N];
+        float m_cos[N/2];
+        float m_sin[N/2];
+
+        float m_re[N];
+        float m_im[N];
+
+        // 0 = load, 1..LOG2N = butterfly stages, LOG2N+1 = magnitudes
+        uint8_t m_step;
+
+        static uint16_t reverse(const uint16_t k)
+        {
+            uint16_t r = 0;
+
+            for (uint8_t b=0; b<LOG2N; ++b) {
+                r |= ((k >> b) & 1) << (LOG2N - 1 - b);
+            }
+
+            return r;
+        }
+
+        void load(const float input[])
+        {
+            for (uint16_t k=0; k<N; ++k) {
+                const auto r = reverse(k);
+                m_re[r] = input[k] * m_window[k];
+                m_im[r] = 0;
+            }
+        }
+
+        void butterflies(const uint8_t stage)
+        {
+            const uint16_t half = 1 << (stage - 1);
+            const uint16_t stride = N / (2 * half);
+
+            for (uint16_t start=0; start<N; start+=2*half) {
+
+                for (uint16_t j=0; j<half; ++j) {
+
+                    const auto c = m_cos[j * stride];
+                    const auto s = m_sin[j * stride];
+
+                    const auto a = start + j;
+                    const auto b = a + half;
+
+                    const auto tre = m_re[b] * c + m_im[b] * s;
+                    const auto tim = m_im[b] * c - m_re[b] * s;
+
+                    m_re[b] = m_re[a] - tre;
+                    m_im[b] = m_im[a] - tim;
+                    m_re[a] += tre;
+                    m_im[a] += tim;
+                }
+            }
+        }
+
+        void magnitudes(float bins[])
+        {
+            // Hann window has a coherent gain of 1/2, so a sine of amplitude
+            // A shows up as A in its bin
+            for (uint16_t k=0; k<BINS; ++k) {
+                bins[k] =
+                    4 * sqrtf(m_re[k] * m_re[k] + m_im[k] * m_im[k]) / N;
+            }
+        }
+
+    public:
+
+        IncrementalFft(void)
+        {
+            for (uint16_t k=0; k<N; ++k) {
+                m_window[k] = 0.5f * (1 - cosf(2 * M_PI * k / N));
+            }
+
+            for (uint16_t k=0; k<N/2; ++k) {
+                m_cos[k] = cosf(2 * M_PI * k / N);
+                m_sin[k] = sinf(2 * M_PI * k / N);
+            }
+
+            m_step = 0;
+        }
+
+        void reset(void)
+        {
+            m_step = 0;
+        }
+
+        // Runs the next step over input; returns true when bins[] holds the
+        // magnitude of each of the BINS frequencies.  The same input must be
+        // passed until then.
+        bool step(const float input[], float bins[])
+        {
+            if (m_step == 0) {
+                load(input);
+            }
+
+            else if (m_step <= LOG2N) {
+                butterflies(m_step);
+            }
+
+            else {
+                magnitudes(bins);
+                m_step = 0;
+                return true;
+            }
+
+            m_step++;
+
+            return false;
+        }
+
+}; // class IncrementalFft
@@ -0,0 +1,122 @@
+/*
+   Copyright (c) 2022 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under the
+   terms of the GNU General Public License as published by the Free Software
+   Foundation, either version 3 of the License, or (at your option) any later
+   version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+   PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+
+#include "core/pid.h"
+#include "core/sections.h"
+
+// Second-order (biquad) filter, lowpass or notch
+class BiquadFilter {
+
+    public:
+
+        typedef enum {
+
+            LOWPASS,
+            NOTCH
+
+        } type_e;
+
+        static constexpr float Q_BUTTERWORTH = 0.70710678f; // 1 / sqrt(2)
+
+    private:
+
+        float m_b0;
+        float m_b1;
+        float m_b2;
+        float m_a1;
+        float m_a2;
+
+        float m_x1;
+        float m_x2;
+
+        float m_dt;
+
+        type_e m_type;
+        float  m_q;
+
+    public:
+
+        BiquadFilter(
+                const float f_cut,
+                const float dt=PidController::DT,
+                const float q=Q_BUTTERWORTH,
+                const type_e type=LOWPASS)
+        {
+            m_x1 = 0;
+            m_x2 = 0;
+            m_dt = dt;
+            m_q = q;
+            m_type = type;
+
+            computeGain(f_cut);
+        }
+
+        // Q for a notch at centerFreq whose -3dB point is at cutoffFreq
+        static float notchQ(const float centerFreq, const float cutoffFreq)
+        {
+            return centerFreq * cutoffFreq /
+                (centerFreq * centerFreq - cutoffFreq * cutoffFreq);
+        }
+
+        // Direct form 2, transposed
+        FAST_CODE float apply(const float input)
+        {
+            const auto result = m_b0 * input + m_x1;
+
+            m_x1 = m_b1 * input - m_a1 * result + m_x2;
+            m_x2 = m_b2 * input - m_a2 * result;
+
+            return result;
+        }
+
+        void computeGain(const float f_cut)
+        {
+            const auto omega = 2 * M_PI * f_cut * m_dt;
+            const auto sn = sinf(omega);
+            const auto cs = cosf(omega);
+            const auto alpha = sn / (2 * m_q);
+
+            const auto a0 = 1 + alpha;
+
+            if (m_type == LOWPASS) {
+                m_b0 = (1 - cs) / 2 / a0;
+                m_b1 = (1 - cs) / a0;
+                m_b2 = m_b0;
+            }
+            else {
+                m_b0 = 1 / a0;
+                m_b1 = -2 * cs / a0;
+                m_b2 = m_b0;
+            }
+
+            m_a1 = -2 * cs / a0;
+            m_a2 = (1 - alpha) / a0;
+        }
+
+        // For a loop rate chosen at run time; the caller recomputes the
+        // coefficients
+        void setDt(const float dt)
+        {
+            m_dt = dt;
+        }
+
+}; // class BiquadFilter
@@ -0,0 +1,171 @@
+/*
+   Copyright (c) 2022 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under the
+   terms of the GNU General Public License as published by the Free Software
+   Foundation, either version 3 of the License, or (at your option) any later
+   version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+   PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "core/filters/biquad.h"
+#include "core/sections.h"
+
+// Filter chains whose stages are fixed by type, so that a board or build can
+// swap in a different chain without touching the control code, e.g.:
+//
+//   FilterChain<Lowpass<Pt1Filter, 500>, Notch<200, 150>, Lowpass<Pt1Filter, 250>>
+//
+// For loop rates above 8 kHz, PrecisePt1Filter and PrecisePt2Filter
+// (core/filters/precise.h) can stand in for Pt1Filter and Pt2Filter.
+//
+// Stage cutoffs are template parameters, so every chain is default
+// constructible.  Setting a stage's ENABLED parameter to false replaces it with
+// a pass-through that the compiler removes entirely.  Every stage provides
+// setDt(), which re-derives its coefficients once the loop rate is chosen.
+
+template <class F, uint16_t CUTOFF_HZ, bool ENABLED=true>
+class Lowpass : public F {
+
+    public:
+
+        Lowpass(void)
+            : F(CUTOFF_HZ)
+        {
+        }
+
+        void setDt(const float dt)
+        {
+            F::setDt(dt);
+            F::computeGain(CUTOFF_HZ);
+        }
+
+}; // class Lowpass
+
+template <class F, uint16_t CUTOFF_HZ>
+class Lowpass<F, CUTOFF_HZ, false> {
+
+    public:
+
+        float apply(const float input)
+        {
+            return input;
+        }
+
+        void computeGain(const float f_cut)
+        {
+            (void)f_cut;
+        }
+
+        void setDt(const float dt)
+        {
+            (void)dt;
+        }
+
+}; // class Lowpass
+
+template <uint16_t CENTER_HZ, uint16_t CUTOFF_HZ, bool ENABLED=true>
+class Notch : public BiquadFilter {
+
+    public:
+
+        Notch(void)
+            : BiquadFilter(
+                    CENTER_HZ,
+                    PidController::DT,
+                    notchQ(CENTER_HZ, CUTOFF_HZ),
+                    NOTCH)
+        {
+        }
+
+        void setDt(const float dt)
+        {
+            BiquadFilter::setDt(dt);
+            computeGain(CENTER_HZ);
+        }
+
+}; // class Notch
+
+template <uint16_t CENTER_HZ, uint16_t CUTOFF_HZ>
+class Notch<CENTER_HZ, CUTOFF_HZ, false> {
+
+    public:
+
+        float apply(const float input)
+        {
+            return input;
+        }
+
+        void setDt(const float dt)
+        {
+            (void)dt;
+        }
+
+}; // class Notch
+
+template <class... Stages>
+class FilterChain;
+
+template <>
+class FilterChain<> {
+
+    public:
+
+        float apply(const float input)
+        {
+            return input;
+        }
+
+        void setDt(const float dt)
+        {
+            (void)dt;
+        }
+
+}; // class FilterChain
+
+template <class Stage, class... Rest>
+class FilterChain<Stage, Rest...> {
+
+    private:
+
+        Stage m_stage;
+
+        FilterChain<Rest...> m_rest;
+
+    public:
+
+        FAST_CODE float apply(const float input)
+        {
+            return m_rest.apply(m_stage.apply(input));
+        }
+
+        void setDt(const float dt)
+        {
+            m_stage.setDt(dt);
+            m_rest.setDt(dt);
+        }
+
+        // For updating a dynamic cutoff
+        Stage & first(void)
+        {
+            return m_stage;
+        }
+
+        FilterChain<Rest...> & rest(void)
+        {
+            return m_rest;
+        }
+
+}; // class FilterChain
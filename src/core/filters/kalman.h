@@ -0,0 +1,124 @@
+/*
+   Copyright (c) 2022 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under the
+   terms of the GNU General Public License as published by the Free Software
+   Foundation, either version 3 of the License, or (at your option) any later
+   version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+   PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+#include "core/pid.h"
+#include "core/sections.h"
+
+// Adaptive per-axis gyro filter: a Kalman filter on a constant rate, whose
+// measurement noise is estimated online from the spread of its recent
+// innovations (measurement minus prediction).  In calm flight the
+// innovations are small, so the gain rises and delay drops; when they grow
+// the gain falls and filtering increases.  Q is process noise per second,
+// scaled by the loop period, so the gain holds its bandwidth in Hz at any
+// loop rate.  The defaults were tuned with utils/filtertrace.
+//
+// Default constructible, so it can be used directly as a FilterChain stage.
+template <uint16_t Q=8000, uint8_t WINDOW=32>
+class KalmanFilter {
+
+    private:
+
+        static constexpr float INITIAL_R = 88;
+        static constexpr float R_SCALE   = 0.4;
+
+        float m_q;
+        float m_r;
+        float m_p;
+        float m_x;
+
+        // Sliding window of innovations
+        float   m_window[WINDOW];
+        uint8_t m_index;
+        float   m_sum;
+        float   m_sumSquares;
+
+        void updateNoise(const float innovation)
+        {
+            const auto oldest = m_window[m_index];
+
+            m_window[m_index] = innovation;
+            m_index = (m_index + 1) % WINDOW;
+
+            m_sum += innovation - oldest;
+            m_sumSquares += innovation * innovation - oldest * oldest;
+
+            // Running sums drift; recompute them once per window
+            if (m_index == 0) {
+                m_sum = 0;
+                m_sumSquares = 0;
+                for (uint8_t k=0; k<WINDOW; ++k) {
+                    m_sum += m_window[k];
+                    m_sumSquares += m_window[k] * m_window[k];
+                }
+            }
+
+            const auto mean = m_sum / WINDOW;
+
+            const auto variance =
+                fabsf(m_sumSquares / WINDOW - mean * mean);
+
+            m_r = sqrtf(variance) * R_SCALE;
+        }
+
+    public:
+
+        KalmanFilter(const float dt=PidController::DT)
+        {
+            m_q = Q * dt;
+            m_r = INITIAL_R;
+            m_p = 0;
+            m_x = 0;
+
+            for (uint8_t k=0; k<WINDOW; ++k) {
+                m_window[k] = 0;
+            }
+            m_index = 0;
+            m_sum = 0;
+            m_sumSquares = 0;
+        }
+
+        FAST_CODE float apply(const float input)
+        {
+            // Predict no change in rate; extrapolating the last change
+            // amplifies the noise more than it cuts the delay
+            const auto innovation = input - m_x;
+
+            updateNoise(innovation);
+
+            m_p += m_q;
+
+            const auto k = m_p / (m_p + m_r);
+
+            m_x += k * innovation;
+
+            m_p *= 1 - k;
+
+            return m_x;
+        }
+
+        void setDt(const float dt)
+        {
+            m_q = Q * dt;
+        }
+
+}; // class KalmanFilter
@@ -0,0 +1,139 @@
+/*
+   Copyright (c) 2022 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under the
+   terms of the GNU General Public License as published by the Free Software
+   Foundation, either version 3 of the License, or (at your option) any later
+   version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+   PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <math.h>
+
+#include "core/filters/pt1.h"
+#include "core/filters/pt2.h"
+#include "core/pid.h"
+#include "core/sections.h"
+
+// PT1 and PT2 lowpass filters that stay accurate at high loop rates.  With a
+// 16-32 kHz loop, a low cutoff gives a gain small enough that the increment
+// k * (input - state) falls below the precision of the state, so the plain
+// filters stall short of the input (bias) or wander around it (limit
+// cycles).  These carry each update's rounding error into the next one
+// (Kahan summation) at a cost of three extra adds per stage.
+//
+// The compensation relies on strict float evaluation, so don't build these
+// with -ffast-math.
+
+class CompensatedState {
+
+    private:
+
+        float m_value;
+        float m_carry; // rounding error of the last update, negated
+
+    public:
+
+        CompensatedState(void)
+        {
+            m_value = 0;
+            m_carry = 0;
+        }
+
+        float get(void) const
+        {
+            return m_value;
+        }
+
+        // One lowpass step: state += k * (input - state)
+        FAST_CODE float update(const float k, const float input)
+        {
+            const auto increment = k * ((input - m_value) + m_carry) - m_carry;
+            const auto sum = m_value + increment;
+
+            m_carry = (sum - m_value) - increment;
+            m_value = sum;
+
+            return m_value;
+        }
+
+}; // class CompensatedState
+
+class PrecisePt1Filter {
+
+    private:
+
+        CompensatedState m_state;
+        float m_dt;
+        float m_k;
+
+    public:
+
+        PrecisePt1Filter(const float f_cut, const float dt=PidController::DT)
+        {
+            m_dt = dt;
+
+            computeGain(f_cut);
+        }
+
+        FAST_CODE float apply(const float input)
+        {
+            return m_state.update(m_k, input);
+        }
+
+        void computeGain(const float f_cut)
+        {
+            m_k = Pt1Filter::gain(f_cut, m_dt);
+        }
+
+        void setDt(const float dt)
+        {
+            m_dt = dt;
+        }
+
+}; // class PrecisePt1Filter
+
+class PrecisePt2Filter {
+
+    private:
+
+        CompensatedState m_state;
+        CompensatedState m_state1;
+        float m_dt;
+        float m_k;
+
+    public:
+
+        PrecisePt2Filter(const float f_cut, const float dt=PidController::DT)
+        {
+            m_dt = dt;
+
+            computeGain(f_cut);
+        }
+
+        FAST_CODE float apply(const float input)
+        {
+            return m_state.update(m_k, m_state1.update(m_k, input));
+        }
+
+        void computeGain(const float f_cut)
+        {
+            m_k = Pt2Filter::gain(f_cut, m_dt);
+        }
+
+        void setDt(const float dt)
+        {
+            m_dt = dt;
+        }
+
+}; // class PrecisePt2Filter
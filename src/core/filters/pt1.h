@@ -21,6 +21,7 @@
 #include <math.h>
 
 #include "core/pid.h"
+#include "core/sections.h"
 
 // PT1 Low Pass filter
 class Pt1Filter {
@@ -41,16 +42,33 @@ class Pt1Filter {
             computeGain(f_cut);
         }
 
-        float apply(const float input)
+        FAST_CODE float apply(const float input)
         {
             m_state = m_state + m_k * (input - m_state);
             return m_state;
         }
 
         void computeGain(const float f_cut)
+        {
+            m_k = gain(f_cut, m_dt);
+        }
+
+        // For a loop rate chosen at run time; the caller recomputes the gain
+        void setDt(const float dt)
+        {
+            m_dt = dt;
+        }
+
+        // For gains precomputed outside the core loop
+        void setGain(const float k)
+        {
+            m_k = k;
+        }
+
+        static float gain(const float f_cut, const float dt=PidController::DT)
         {
             float rc = 1 / (2 * M_PI * f_cut);
-            m_k = m_dt / (rc + m_dt);
+            return dt / (rc + dt);
         }
 
 }; // class Pt1Filter
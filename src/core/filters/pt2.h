@@ -21,6 +21,7 @@
 #include <math.h>
 
 #include "core/pid.h"
+#include "core/sections.h"
 
 // PT2 Low Pass filter
 class Pt2Filter {
@@ -43,7 +44,7 @@ class Pt2Filter {
             computeGain(f_cut);
         }
 
-        float apply(const float input)
+        FAST_CODE float apply(const float input)
         {
             m_state1 = m_state1 + m_k * (input - m_state1);
             m_state = m_state + m_k * (m_state1 - m_state);
@@ -51,11 +52,22 @@ class Pt2Filter {
          }
 
         void computeGain(const float f_cut)
+        {
+            m_k = gain(f_cut, m_dt);
+        }
+
+        // For a loop rate chosen at run time; the caller recomputes the gain
+        void setDt(const float dt)
+        {
+            m_dt = dt;
+        }
+
+        static float gain(const float f_cut, const float dt=PidController::DT)
         {
             const float order = 2.0f;
             const float orderCutoffCorrection = 1 / sqrtf(powf(2, 1.0f / order) - 1);
             float rc = 1 / (2 * orderCutoffCorrection * M_PI * f_cut);
-            m_k = m_dt / (rc + m_dt);
-         }
+            return dt / (rc + dt);
+        }
 
 }; // class Pt2Filter
@@ -0,0 +1,110 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Vector-like container whose storage is sized at compile time, so it never
+// touches the heap.  Initializing with more than CAPACITY elements is a
+// compile-time error; push_back() past CAPACITY returns false.
+template <class T, uint8_t CAPACITY>
+class FixedVector {
+
+    private:
+
+        T m_items[CAPACITY];
+
+        uint8_t m_size;
+
+    public:
+
+        FixedVector(void)
+        {
+            m_size = 0;
+        }
+
+        // Elements are passed separately rather than as an initializer_list,
+        // whose size isn't a constant expression
+        template <class... U>
+        FixedVector(const T & first, const U & ... rest)
+            : FixedVector()
+        {
+            static_assert(1 + sizeof...(rest) <= CAPACITY,
+                    "too many elements for FixedVector capacity");
+
+            const T items[] = {first, T(rest)...};
+
+            for (auto item : items) {
+                push_back(item);
+            }
+        }
+
+        bool push_back(const T item)
+        {
+            if (m_size == CAPACITY) {
+                return false;
+            }
+
+            m_items[m_size++] = item;
+
+            return true;
+        }
+
+        uint8_t size(void) const
+        {
+            return m_size;
+        }
+
+        static uint8_t capacity(void)
+        {
+            return CAPACITY;
+        }
+
+        T & operator[](const uint8_t index)
+        {
+            return m_items[index];
+        }
+
+        const T & operator[](const uint8_t index) const
+        {
+            return m_items[index];
+        }
+
+        T * begin(void)
+        {
+            return m_items;
+        }
+
+        T * end(void)
+        {
+            return m_items + m_size;
+        }
+
+        const T * begin(void) const
+        {
+            return m_items;
+        }
+
+        const T * end(void) const
+        {
+            return m_items + m_size;
+        }
+
+}; // class FixedVector
@@ -0,0 +1,136 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "core/pid.h"
+
+// A sketch can define LOOP_HEADROOM_PERCENT before including Hackflight
+// headers (or a build can pass it with -D) to reserve a different share of
+// each loop for the dynamic tasks
+#if !defined(LOOP_HEADROOM_PERCENT)
+#define LOOP_HEADROOM_PERCENT 50
+#endif
+
+// Boot-time choice of core loop rate.  The loop starts at the gyro rate;
+// the core path (gyro pipeline, PID controllers, mixer, ESC write) is timed
+// over its first passes, and the highest of 8, 4 and 2 kHz whose period
+// leaves LOOP_HEADROOM_PERCENT free is chosen.  A board too slow even for
+// 2 kHz runs at 2 kHz with less headroom.
+class LoopRate {
+
+    public:
+
+        typedef enum {
+
+            FREQ_HZ,        // chosen loop rate
+            CORE_PERCENT,   // share of its period the core path takes
+            HEADROOM,       // configured headroom, percent
+
+            COUNT
+
+        } report_e;
+
+    private:
+
+        // Passes skipped while caches and ESCs settle, then timed
+        static const uint16_t WARMUP_COUNT = 100;
+        static const uint16_t TIMED_COUNT  = 400;
+
+        // The loop runs at the gyro rate divided by 1 up to this
+        static const uint8_t MAX_DIVIDER = 4;
+
+        uint16_t m_count;
+        uint32_t m_totalCycles;
+        uint8_t  m_divider;
+
+        int16_t m_report[COUNT];
+
+    public:
+
+        LoopRate(void)
+        {
+            m_count = 0;
+            m_totalCycles = 0;
+            m_divider = 1;
+
+            m_report[FREQ_HZ] = 0;
+            m_report[CORE_PERCENT] = 0;
+            m_report[HEADROOM] = LOOP_HEADROOM_PERCENT;
+        }
+
+        bool isCalibrating(void) const
+        {
+            return m_count < WARMUP_COUNT + TIMED_COUNT;
+        }
+
+        // Takes the clock cycles for one pass of the core path and for one
+        // gyro period; returns true on the pass that chooses the rate
+        bool update(const uint32_t coreCycles, const uint32_t gyroPeriodCycles)
+        {
+            if (++m_count <= WARMUP_COUNT) {
+                return false;
+            }
+
+            m_totalCycles += coreCycles;
+
+            if (isCalibrating()) {
+                return false;
+            }
+
+            const auto meanCycles = m_totalCycles / TIMED_COUNT;
+
+            const uint32_t usablePercent = 100 - LOOP_HEADROOM_PERCENT;
+
+            while (m_divider < MAX_DIVIDER && 100 * meanCycles >
+                    usablePercent * m_divider * gyroPeriodCycles) {
+                m_divider *= 2;
+            }
+
+            m_report[FREQ_HZ] = (int16_t)getFrequency();
+            m_report[CORE_PERCENT] =
+                (int16_t)(100 * meanCycles / (m_divider * gyroPeriodCycles));
+
+            return true;
+        }
+
+        // Gyro samples per core loop
+        uint8_t getDivider(void) const
+        {
+            return m_divider;
+        }
+
+        uint32_t getFrequency(void) const
+        {
+            return 1000000 / (PidController::PERIOD * m_divider);
+        }
+
+        float getDt(void) const
+        {
+            return PidController::DT * m_divider;
+        }
+
+        const int16_t * get(void) const
+        {
+            return m_report;
+        }
+
+}; // class LoopRate
@@ -23,8 +23,6 @@
 #include "pid.h"
 #include "vstate.h"
 
-#include <vector>
-
 class Mixer {
 
     private:
@@ -24,12 +24,13 @@
 #include "core/axes.h"
 #include "core/constrain.h"
 #include "core/mixer.h"
+#include "core/sections.h"
 
 class FixedPitchMixer : public Mixer {
 
     public:
 
-        static void fun(
+        FAST_CODE static void fun(
                 const Demands & demands,
                 const uint8_t motorCount,
                 const Axes spins[],
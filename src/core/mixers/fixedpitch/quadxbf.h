@@ -29,12 +29,13 @@
 
 #include "core/axes.h"
 #include "core/mixers/fixedpitch.h"
+#include "core/sections.h"
 
 class QuadXbfMixer {
 
     private:
 
-        static void fun(const Demands & demands, float motors[])
+        FAST_CODE static void fun(const Demands & demands, float motors[])
         {
             Axes SPINS[4] = {
                 //  rol   pit    yaw
@@ -0,0 +1,115 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "core/filters/pt1.h"
+
+// Tunable parameters for the PID controllers, plus the quantities derived
+// from them.  Derived values are computed by derive(), never in the core
+// loop.
+class Parameters {
+
+    public:
+
+        typedef enum {
+
+            ANGLE_RATE_P,
+            ANGLE_RATE_I,
+            ANGLE_RATE_D,
+            ANGLE_RATE_F,
+            ANGLE_LEVEL_P,
+            ANGLE_RATE_MAX,     // deg/sec at full stick
+            ANGLE_RATE_CENTER,  // linear share of the stick curve
+            ANGLE_YAW_LPF_HZ,
+
+            ALTHOLD_P,
+            ALTHOLD_I,
+            ALTHOLD_ALT_MIN,
+            ALTHOLD_PILOT_VELZ_MAX,
+            ALTHOLD_STICK_DEADBAND,
+            ALTHOLD_WINDUP_MAX,
+
+            FLOWHOLD_P,
+            FLOWHOLD_I,
+            FLOWHOLD_PILOT_VELY_MAX,
+            FLOWHOLD_STICK_DEADBAND,
+            FLOWHOLD_WINDUP_MAX,
+
+            COUNT
+
+        } index_e;
+
+        float values[COUNT];
+
+        // Loop time the derived values are computed for
+        float dt;
+
+        // Derived
+        float yawLpfGain;
+        float rateLinear;
+        float rateQuadratic;
+
+        Parameters(void)
+        {
+            values[ANGLE_RATE_P]      = 1.441305;
+            values[ANGLE_RATE_I]      = 48.8762;
+            values[ANGLE_RATE_D]      = 0.021160;
+            values[ANGLE_RATE_F]      = 0.0165048;
+            values[ANGLE_LEVEL_P]     = 0.0; // 3.0
+            values[ANGLE_RATE_MAX]    = 670;
+            values[ANGLE_RATE_CENTER] = 0.104;
+            values[ANGLE_YAW_LPF_HZ]  = 100;
+
+            values[ALTHOLD_P]              = 0.075;
+            values[ALTHOLD_I]              = 0.15;
+            values[ALTHOLD_ALT_MIN]        = 1.0;
+            values[ALTHOLD_PILOT_VELZ_MAX] = 2.5;
+            values[ALTHOLD_STICK_DEADBAND] = 0.2;
+            values[ALTHOLD_WINDUP_MAX]     = 0.4;
+
+            values[FLOWHOLD_P]              = 0.0005;
+            values[FLOWHOLD_I]              = 0.25;
+            values[FLOWHOLD_PILOT_VELY_MAX] = 2.5;
+            values[FLOWHOLD_STICK_DEADBAND] = 0.2;
+            values[FLOWHOLD_WINDUP_MAX]     = 0.4;
+
+            dt = PidController::DT;
+
+            derive();
+        }
+
+        float operator[](const index_e index) const
+        {
+            return values[index];
+        }
+
+        void derive(void)
+        {
+            yawLpfGain = Pt1Filter::gain(values[ANGLE_YAW_LPF_HZ], dt);
+
+            const auto center = values[ANGLE_RATE_CENTER];
+
+            rateLinear = values[ANGLE_RATE_MAX] * center;
+            rateQuadratic = values[ANGLE_RATE_MAX] * (1 - center);
+        }
+
+}; // class Parameters
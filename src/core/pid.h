@@ -19,55 +19,137 @@
 #pragma once
 
 #include "demands.h"
+#include "fixedvector.h"
 #include "utils.h"
 #include "vstate.h"
 
-#include <vector>
+class Parameters;
 
 class PidController {
 
     private:
 
+        // Gyro sample rate, and so the highest loop rate; LoopRate can pick
+        // a divisor of it at boot
         static const uint32_t FREQ_HZ = 8000;
 
+        // Per controller, so that several vehicles' controllers can run
+        // side by side
+        uint32_t m_prevUsec;
+
+        int32_t getDusec(const uint32_t usec)
+        {
+            const auto dusec = intcmp(usec, m_prevUsec);
+
+            m_prevUsec = usec;
+
+            return dusec;
+        }
+
     protected:
 
+         PidController(void)
+         {
+             m_prevUsec = 0;
+         }
+
          virtual void modifyDemands(
                 Demands & demands,
                 const int32_t dusec,
                 const VehicleState & vstate,
+                const Parameters & params,
                 const bool reset) = 0;
 
     public:
 
         static const uint32_t PERIOD = 1000000 / FREQ_HZ;
 
+        static const uint8_t MAX_CONTROLLERS = 8; // arbitrary
+
+        typedef FixedVector<PidController *, MAX_CONTROLLERS> list_t;
+
         static constexpr float DT = PERIOD * 1e-6f;
 
          void update(
                 Demands & demands,
                 const uint32_t usec,
                 const VehicleState & vstate,
+                const Parameters & params,
                 const bool reset)
          {
-             static uint32_t _prev;
+             modifyDemands(demands, getDusec(usec), vstate, params, reset);
+         }
 
-             const auto dusec = intcmp(usec, _prev);
+         // Re-derives anything that depends on the loop time, once the loop
+         // rate has been chosen
+         virtual void setDt(const float dt)
+         {
+             (void)dt;
+         }
 
-             _prev = usec;
+         static void setLoopDt(list_t & pidControllers, const float dt)
+         {
+             for (auto p: pidControllers) {
+                 p->setDt(dt);
+             }
+         }
 
-             modifyDemands(demands, dusec, vstate, reset);
+         static void setLoopDt(const float dt)
+         {
+             (void)dt;
+         }
+
+         template <class PidT, class... Rest>
+         static void setLoopDt(const float dt, PidT & pid, Rest & ... rest)
+         {
+             pid.PidT::setDt(dt);
+
+             setLoopDt(dt, rest...);
          }
 
          static void run(
-                 std::vector<PidController *> & pidControllers,
+                 list_t & pidControllers,
                  Demands & demands,
                  const VehicleState & vstate,
+                 const Parameters & params,
                  const uint32_t usec,
                  const bool reset)
          {
              for (auto p: pidControllers) {
-                 p->update(demands, usec, vstate, reset);
+                 p->update(demands, usec, vstate, params, reset);
              }
          }
+
+         // Static-dispatch versions for boards that know their PID
+         // controller types at compile time: the qualified call lets
+         // modifyDemands() be inlined
+         static void run(
+                 Demands & demands,
+                 const VehicleState & vstate,
+                 const Parameters & params,
+                 const uint32_t usec,
+                 const bool reset)
+         {
+             (void)demands;
+             (void)vstate;
+             (void)params;
+             (void)usec;
+             (void)reset;
+         }
+
+         template <class PidT, class... Rest>
+         static void run(
+                 Demands & demands,
+                 const VehicleState & vstate,
+                 const Parameters & params,
+                 const uint32_t usec,
+                 const bool reset,
+                 PidT & pid,
+                 Rest & ... rest)
+         {
+             pid.PidT::modifyDemands(
+                     demands, pid.getDusec(usec), vstate, params, reset);
+
+             run(demands, vstate, params, usec, reset, rest...);
+         }
 };
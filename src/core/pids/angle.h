@@ -24,29 +24,20 @@
 #include "core/constrain.h"
 #include "core/filters/pt1.h"
 #include "core/filters/pt2.h"
+#include "core/parameters.h"
 #include "core/pid.h"
+#include "core/sections.h"
 #include "core/utils.h"
 
 class AnglePidController : public PidController {
 
     private:
 
-        // minimum of 5ms between updates
-        static const uint16_t DYN_LPF_THROTTLE_UPDATE_DELAY_US = 5000; 
-
-        static const uint16_t DYN_LPF_THROTTLE_STEPS = 100;
-
         // Full iterm suppression in setpoint mode at high-passed setpoint rate
         // > 40deg/sec
         static constexpr float ITERM_RELAX_SETPOINT_THRESHOLD = 40;
         static const uint8_t   ITERM_RELAX_CUTOFF     = 15;
 
-        static const uint16_t DTERM_LPF1_DYN_MIN_HZ = 75;
-        static const uint16_t DTERM_LPF1_DYN_MAX_HZ = 150;
-        static const uint16_t DTERM_LPF2_HZ         = 150;
-
-        static const uint16_t YAW_LOWPASS_HZ        = 100;
-
         static const uint8_t  ITERM_WINDUP_POINT_PERCENT = 85;        
 
         static const uint8_t D_MIN = 30;
@@ -55,11 +46,6 @@ class AnglePidController : public PidController {
 
         static const uint8_t FEEDFORWARD_MAX_RATE_LIMIT = 90;
 
-        static const uint8_t DYN_LPF_CURVE_EXPO = 5;
-
-        // PT2 lowpass input cutoff to peak D around propwash frequencies
-        static constexpr float D_MIN_RANGE_HZ   = 85;  
-
         // PT2 lowpass cutoff to smooth the boost effect
         static constexpr float D_MIN_LOWPASS_HZ = 35;  
         static constexpr float D_MIN_GAIN_FACTOR          = 0.00008;
@@ -75,19 +61,19 @@ class AnglePidController : public PidController {
         static const uint16_t  LIMIT_YAW  = 400;
         static const uint16_t  LIMIT      = 500;
 
-        static float MAX_VELOCITY_CYCLIC() 
+        float MAX_VELOCITY_CYCLIC() 
         {
-            return RATE_ACCEL_LIMIT * 100 * DT;
+            return RATE_ACCEL_LIMIT * 100 * m_dt;
         }
 
-        static float MAX_VELOCITY_YAW() 
+        float MAX_VELOCITY_YAW() 
         {
-            return YAW_RATE_ACCEL_LIMIT * 100 * DT; 
+            return YAW_RATE_ACCEL_LIMIT * 100 * m_dt; 
         }
 
-        static float FREQUENCY() 
+        float FREQUENCY() 
         {
-            return 1.0f / DT; 
+            return m_frequency; 
         }
 
         // Common values for all three axes
@@ -102,28 +88,30 @@ class AnglePidController : public PidController {
         typedef struct {
 
             axis_t    axis;
-            Pt1Filter dtermLpf1 = Pt1Filter(DTERM_LPF1_DYN_MIN_HZ);
-            Pt1Filter dtermLpf2 = Pt1Filter(DTERM_LPF2_HZ);
             Pt2Filter dMinLpf = Pt2Filter(D_MIN_LOWPASS_HZ);
-            Pt2Filter dMinRange = Pt2Filter(D_MIN_RANGE_HZ);
             Pt1Filter windupLpf = Pt1Filter(ITERM_RELAX_CUTOFF); 
-            float     previousDterm;
 
         } cyclicAxis_t;
 
-        // Value for yaw
-        Pt1Filter m_ptermYawLpf = Pt1Filter(YAW_LOWPASS_HZ);
+        // Value for yaw; gain comes from the parameters
+        Pt1Filter m_ptermYawLpf = Pt1Filter(1);
 
         cyclicAxis_t m_roll;
         cyclicAxis_t m_pitch;
         axis_t       m_yaw;
 
-        int32_t  m_dynLpfPreviousQuantizedThrottle;  
+        // Loop time, until the boot-time loop rate is chosen
+        float m_dt = DT;
+        float m_frequency = 1.0f / DT;
+
         float    m_k_rate_p;
         float    m_k_rate_i;
         float    m_k_rate_d;
         float    m_k_rate_f;
         float    m_k_level_p;
+        float    m_rate_max;
+        float    m_rate_linear;
+        float    m_rate_quadratic;
 
         float applyFeedforwardLimit(
                 const float value,
@@ -179,33 +167,7 @@ class AnglePidController : public PidController {
             return itermErrorRate * (!isDecreasingI ? itermRelaxFactor : 1);
         }
 
-        static float dynLpfCutoffFreq(
-                const float throttle,
-                const uint16_t dynLpfMin,
-                const uint16_t dynLpfMax,
-                const uint8_t expo) {
-            const float expof = expo / 10.0f;
-            const auto curve = throttle * (1 - throttle) * expof + throttle;
-            return (dynLpfMax - dynLpfMin) * curve + dynLpfMin;
-        }
-
-        static void initLpf1(cyclicAxis_t & cyclicAxis, const float cutoffFreq)
-        {
-            cyclicAxis.dtermLpf1.computeGain(cutoffFreq);
-        }
-
-        void pidDynLpfDTermUpdate(const float throttle)
-        {
-            const auto dyn_lpf_min = DTERM_LPF1_DYN_MIN_HZ;
-            const auto dyn_lpf_max = DTERM_LPF1_DYN_MAX_HZ;
-            const auto cutoffFreq =
-                dynLpfCutoffFreq(throttle, dyn_lpf_min, dyn_lpf_max,
-                        DYN_LPF_CURVE_EXPO);
-
-            initLpf1(m_roll, cutoffFreq);
-            initLpf1(m_pitch, cutoffFreq);
-        }
-
+        // Angle in radians, from the gravity vector
         float levelPid(const float currentSetpoint, const float currentAngle)
         {
             // calculate error angle and limit the angle to the max inclination
@@ -214,7 +176,7 @@ class AnglePidController : public PidController {
             const auto angle = constrain_f(LEVEL_ANGLE_LIMIT * currentSetpoint,
                     -LEVEL_ANGLE_LIMIT, +LEVEL_ANGLE_LIMIT);
 
-            const auto angleError = angle - (currentAngle / 10);
+            const auto angleError = angle - currentAngle * (180 / (float)M_PI);
 
             return m_k_level_p > 0 ?
                 angleError * m_k_level_p :
@@ -242,7 +204,7 @@ class AnglePidController : public PidController {
                 feedForward;
         }
 
-        float computeDMinFactor(
+        FAST_CODE float computeDMinFactor(
                 cyclicAxis_t & cyclicAxis,
                 const float dMinPercent,
                 const float demandDelta,
@@ -251,8 +213,9 @@ class AnglePidController : public PidController {
             const auto d_min_gyro_gain =
                 D_MIN_GAIN * D_MIN_GAIN_FACTOR / D_MIN_LOWPASS_HZ;
 
-            const auto dMinGyroFactor = 
-                fabsf(cyclicAxis.dMinRange.apply(delta)) * d_min_gyro_gain;
+            // Angular acceleration is already filtered, so there's no
+            // separate D-min range filter
+            const auto dMinGyroFactor = fabsf(delta) * d_min_gyro_gain;
 
             const auto d_min_setpoint_gain =
                 D_MIN_GAIN * D_MIN_SETPOINT_GAIN_FACTOR *
@@ -270,17 +233,15 @@ class AnglePidController : public PidController {
             return fminf(dMinFactorFiltered, 1.0f);
         }
 
-        float computeDerivative(
+        FAST_CODE float computeDerivative(
                 cyclicAxis_t & cyclicAxis,
                 const float demandDelta,
-                const float dterm)
+                const float angaccel)
         {
-            // Divide rate change by dT to get differential (ie dr/dt).
-            // dT is fixed and calculated from the target PID loop time
-            // This is done to avoid DTerm spikes that occur with
-            // dynamically calculated deltaT whenever another task causes
-            // the PID loop execution to be delayed.
-            const float delta = -(dterm - cyclicAxis.previousDterm) * FREQUENCY();
+            // Angular acceleration comes from the IMU, which differentiates
+            // over the fixed loop time to avoid D-term spikes when another
+            // task delays the PID loop
+            const float delta = -angaccel;
 
             const auto preTpaD = m_k_rate_d * delta;
 
@@ -298,10 +259,11 @@ class AnglePidController : public PidController {
             return preTpaD * dMinFactor;
         }
 
-        float updateCyclic(
+        FAST_CODE float updateCyclic(
                 const float demand,
                 const float angle,
                 const float angvel,
+                const float angaccel,
                 cyclicAxis_t & cyclicAxis)
         {
             const auto maxVelocity = MAX_VELOCITY_CYCLIC();
@@ -329,34 +291,31 @@ class AnglePidController : public PidController {
 
             // -----calculate I component
             axis->I =
-                constrain_f(axis->I + (m_k_rate_i * DT) * itermErrorRate,
+                constrain_f(axis->I + (m_k_rate_i * m_dt) * itermErrorRate,
                     -ITERM_LIMIT, +ITERM_LIMIT);
 
             // -----calculate D component
-            const auto dterm = cyclicAxis.dtermLpf2.apply(cyclicAxis.dtermLpf1.apply(angvel));
             const auto D =
                 m_k_rate_d > 0 ?
-                computeDerivative(cyclicAxis, 0, dterm) :
+                computeDerivative(cyclicAxis, 0, angaccel) :
                 0;
 
-            cyclicAxis.previousDterm = dterm;
-
             // -----calculate feedforward component
             const auto F =
                 m_k_rate_f > 0 ?
-                computeFeedforward(newSetpoint, 670, 0) :
+                computeFeedforward(newSetpoint, m_rate_max, 0) :
                 0;
 
             return P + axis->I + D + F;
         }
 
-        float updateYaw(const float demand, const float angvel)
+        FAST_CODE float updateYaw(const float demand, const float angvel)
         {
             // gradually scale back integration when above windup point
             const auto itermWindupPointInv =
                 1 / (1 - (ITERM_WINDUP_POINT_PERCENT / 100));
 
-            const auto dynCi = DT * 
+            const auto dynCi = m_dt * 
                 (itermWindupPointInv > 1 ?
                  constrain_f(itermWindupPointInv, 0, 1) :
                  1);
@@ -386,50 +345,74 @@ class AnglePidController : public PidController {
             return constrain_f(demand, -limit, +limit) / OUTPUT_SCALING;
         }
 
-        // [-1,+1] => [-670,+670] with nonlinearity
-        static float rescale(const float command)
+        // [-1,+1] => [-max,+max] deg/sec with nonlinearity
+        float rescale(const float command)
         {
-            static constexpr float CTR = 0.104;
-
             const auto expof = command * fabsf(command);
-            const auto angleRate = command * CTR + (1-CTR) * expof;
-            return 670 * angleRate;
+            return command * m_rate_linear + m_rate_quadratic * expof;
+        }
+
+        // Picks up this loop's parameters, whose derived values are already
+        // computed
+        void loadParameters(const Parameters & params)
+        {
+            m_k_rate_p = params[Parameters::ANGLE_RATE_P];
+            m_k_rate_i = params[Parameters::ANGLE_RATE_I];
+            m_k_rate_d = params[Parameters::ANGLE_RATE_D];
+            m_k_rate_f = params[Parameters::ANGLE_RATE_F];
+            m_k_level_p = params[Parameters::ANGLE_LEVEL_P];
+            m_rate_max = params[Parameters::ANGLE_RATE_MAX];
+
+            m_rate_linear = params.rateLinear;
+            m_rate_quadratic = params.rateQuadratic;
+
+            m_ptermYawLpf.setGain(params.yawLpfGain);
+        }
+
+        void setCyclicDt(cyclicAxis_t & cyclicAxis)
+        {
+            cyclicAxis.dMinLpf.setDt(m_dt);
+            cyclicAxis.dMinLpf.computeGain(D_MIN_LOWPASS_HZ);
+
+            cyclicAxis.windupLpf.setDt(m_dt);
+            cyclicAxis.windupLpf.computeGain(ITERM_RELAX_CUTOFF);
         }
 
     public:
 
-        AnglePidController(
-                const float k_rate_p = 1.441305,
-                const float k_rate_i = 48.8762 ,
-                const float k_rate_d = 0.021160,
-                const float k_rate_f = 0.0165048, 
-                const float k_level_p = 0.0) // 3.0
+        // The yaw P-term filter's gain comes from the parameters, which are
+        // re-derived separately
+        virtual void setDt(const float dt) override
         {
-            m_k_rate_p = k_rate_p;
-            m_k_rate_i = k_rate_i;
-            m_k_rate_d = k_rate_d;
-            m_k_rate_f = k_rate_f;
-            m_k_level_p = k_level_p;
-
-            // to allow an initial zero throttle to set the filter cutoff
-            m_dynLpfPreviousQuantizedThrottle = -1;  
+            m_dt = dt;
+            m_frequency = 1 / dt;
+
+            setCyclicDt(m_roll);
+            setCyclicDt(m_pitch);
         }
 
-        virtual void modifyDemands(
+        FAST_CODE virtual void modifyDemands(
                 Demands & demands,
                 const int32_t dusec,
                 const VehicleState & vstate,
+                const Parameters & params,
                 const bool reset) override
         {
+            (void)dusec;
+
+            loadParameters(params);
+
             const auto rollDemand  = rescale(demands.roll);
             const auto pitchDemand = rescale(demands.pitch);
             const auto yawDemand   = rescale(demands.yaw);
 
-            const auto roll=
-                updateCyclic(rollDemand, vstate.phi, vstate.dphi, m_roll);
+            const auto roll = updateCyclic(
+                    rollDemand, vstate.rollAngle(), vstate.dphi, vstate.ddphi,
+                    m_roll);
 
-            const auto pitch =
-                updateCyclic(pitchDemand, vstate.theta, vstate.dtheta, m_pitch);
+            const auto pitch = updateCyclic(
+                    pitchDemand, vstate.pitchAngle(), vstate.dtheta,
+                    vstate.ddtheta, m_pitch);
 
             const auto yaw = updateYaw(yawDemand, vstate.dpsi);
 
@@ -439,23 +422,6 @@ class AnglePidController : public PidController {
                 m_yaw.I = 0;
             }
 
-            if (dusec >= DYN_LPF_THROTTLE_UPDATE_DELAY_US) {
-
-                // quantize the throttle reduce the number of filter updates
-                const int32_t quantizedThrottle =
-                    lrintf(demands.throttle * DYN_LPF_THROTTLE_STEPS); 
-
-                if (quantizedThrottle != m_dynLpfPreviousQuantizedThrottle) {
-
-                    // scale the quantized value back to the throttle range so the
-                    // filter cutoff steps are repeatable
-                    const auto dynLpfThrottle =
-                        (float)quantizedThrottle / DYN_LPF_THROTTLE_STEPS;
-                    pidDynLpfDTermUpdate(dynLpfThrottle);
-                    m_dynLpfPreviousQuantizedThrottle = quantizedThrottle;
-                }
-            }
-
             demands.roll = constrainOutput(roll, LIMIT);
             demands.pitch = constrainOutput(pitch, LIMIT),
             demands.yaw = -constrainOutput(yaw, LIMIT_YAW);
@@ -40,6 +40,12 @@ class SetPointPid {
 
     public:
 
+        SetPointPid(void)
+        {
+            this->inBandPrev = false;
+            this->errorI = 0;
+        }
+
         void modifyDemand(
                 const float k_p,
                 const float k_i,
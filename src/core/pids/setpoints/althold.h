@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "core/parameters.h"
 #include "core/pid.h"
 #include "core/pids/setpoint.h"
 
@@ -38,14 +39,6 @@ class AltHoldPidController : public PidController {
             return v < -lim ? -lim : v > +lim ? +lim : v;
         }
 
-        float k_p;
-        float k_i;
-
-        float k_alt_min;
-        float k_pilot_velz_max;
-        float k_stick_deadband;
-        float k_windup_max;
-
         float zTarget;
 
         bool inBandPrev;
@@ -53,26 +46,8 @@ class AltHoldPidController : public PidController {
 
     public:
 
-        AltHoldPidController(
-
-                // Tunable
-                const float k_p = 0.075,
-                const float k_i = 0.15,
-
-                // Probably better left as-is
-                const float k_alt_min = 1.0,
-                const float k_pilot_velz_max = 2.5,
-                const float k_stick_deadband = 0.2,
-                const float k_windup_max = 0.4)
+        AltHoldPidController(void)
         {
-            this->k_p = k_p;
-            this->k_i = k_i;
-
-            this->k_alt_min = k_alt_min;
-            this->k_pilot_velz_max = k_pilot_velz_max;
-            this->k_stick_deadband = k_stick_deadband;
-            this->k_windup_max = k_windup_max;
-
             this->inBandPrev = false;
             this->errorI = 0;
             this->zTarget = 0;
@@ -82,6 +57,7 @@ class AltHoldPidController : public PidController {
                 Demands & demands,
                 const int32_t dusec,
                 const VehicleState & vstate,
+                const Parameters & params,
                 const bool reset) override
          {
             (void)dusec;
@@ -89,7 +65,7 @@ class AltHoldPidController : public PidController {
             const auto z = vstate.z;
 
             // Require a minimum altitude
-            if (z < k_alt_min) {
+            if (z < params[Parameters::ALTHOLD_ALT_MIN]) {
                 return;
             }
 
@@ -99,11 +75,11 @@ class AltHoldPidController : public PidController {
             bool movedIntoBand = false;
 
             pid.modifyDemand(
-                k_p,
-                k_i,
-                k_stick_deadband,
-                k_pilot_velz_max,
-                k_windup_max,
+                params[Parameters::ALTHOLD_P],
+                params[Parameters::ALTHOLD_I],
+                params[Parameters::ALTHOLD_STICK_DEADBAND],
+                params[Parameters::ALTHOLD_PILOT_VELZ_MAX],
+                params[Parameters::ALTHOLD_WINDUP_MAX],
                 vstate.dz,
                 this->zTarget - z,
                 reset,
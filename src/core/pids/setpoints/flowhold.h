@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "core/parameters.h"
 #include "core/pid.h"
 #include "core/pids/setpoint.h"
 
@@ -29,14 +30,8 @@ class FlowHoldPidController : public PidController {
         SetPointPid xPid;
         SetPointPid yPid;
 
-        float k_p;
-        float k_i;
-
-        float k_pilot_vely_max;
-        float k_stick_deadband;
-        float k_windup_max;
-
         void modifyDemand(
+                const Parameters & params,
                 const float velocity,
                 const bool reset,
                 SetPointPid & pid,
@@ -48,11 +43,11 @@ class FlowHoldPidController : public PidController {
             bool movedIntoBand = false;
 
             pid.modifyDemand(
-                    k_p,
-                    k_i,
-                    k_stick_deadband,
-                    k_pilot_vely_max,
-                    k_windup_max,
+                    params[Parameters::FLOWHOLD_P],
+                    params[Parameters::FLOWHOLD_I],
+                    params[Parameters::FLOWHOLD_STICK_DEADBAND],
+                    params[Parameters::FLOWHOLD_PILOT_VELY_MAX],
+                    params[Parameters::FLOWHOLD_WINDUP_MAX],
                     velocity,
                     0, // target velocity
                     reset,
@@ -64,34 +59,16 @@ class FlowHoldPidController : public PidController {
 
     public:
 
-        FlowHoldPidController(
-
-                // Tunable
-                const float k_p = 0.0005,
-                const float k_i = 0.25,
-
-                // Probably better left as-is
-                const float k_pilot_vely_max = 2.5,
-                const float k_stick_deadband = 0.2,
-                const float k_windup_max = 0.4)
-        {
-            this->k_p = k_p;
-            this->k_i = k_i;
-
-            this->k_pilot_vely_max = k_pilot_vely_max;
-            this->k_stick_deadband = k_stick_deadband;
-            this->k_windup_max = k_windup_max;
-        }
-
         virtual void modifyDemands(
                 Demands & demands,
                 const int32_t dusec,
                 const VehicleState & vstate,
+                const Parameters & params,
                 const bool reset) override
         {
             (void)dusec;
 
-            modifyDemand(vstate.dy, reset, this->yPid, demands.roll);
+            modifyDemand(params, vstate.dy, reset, this->yPid, demands.roll);
 
         }
 
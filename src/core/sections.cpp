@@ -0,0 +1,83 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+// Defined here rather than in sections.h, so that there is one copy however
+// many translation units include the header
+
+#if defined(USE_FAST_SECTIONS)
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+extern "C" {
+
+    // Provided by utils/ld/hackflight.ld
+    extern uint32_t _sifastcode;
+    extern uint32_t _sfastcode;
+    extern uint32_t _efastcode;
+    extern uint32_t _sifastdata;
+    extern uint32_t _sfastdata;
+    extern uint32_t _efastdata;
+    extern uint8_t  end;
+    extern uint8_t  _eheap;
+
+    // Replaces the core's weak _sbrk(), which takes the heap to end where
+    // the stack begins and so refuses everything once the stack is in CCM
+    // or DTCM
+    void * _sbrk(ptrdiff_t increment)
+    {
+        static uint8_t * heapEnd = &end;
+
+        if (heapEnd + increment > &_eheap) {
+            errno = ENOMEM;
+            return (void *)-1;
+        }
+
+        const auto previous = heapEnd;
+
+        heapEnd += increment;
+
+        return previous;
+    }
+}
+
+static void copy(const uint32_t * src, uint32_t * dst, const uint32_t * stop)
+{
+    while (dst < stop) {
+        *dst++ = *src++;
+    }
+}
+
+// Runs ahead of the default-priority static constructors, so FAST_DATA
+// objects have their initial values (from flash, as for .data) before they
+// are constructed, and FAST_CODE is in place before anything can call it
+__attribute__((constructor(101))) static void initFastSections(void)
+{
+    copy(&_sifastcode, &_sfastcode, &_efastcode);
+
+    copy(&_sifastdata, &_sfastdata, &_efastdata);
+
+#if defined(__arm__)
+    __asm__ volatile ("dsb\n\tisb" ::: "memory");
+#endif
+}
+
+#endif
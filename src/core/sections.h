@@ -0,0 +1,47 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+// Linker-section annotations for the core (gyro/PID/mixer) path.  Building
+// with -DUSE_FAST_SECTIONS and one of the linker scripts in utils/ld places
+// FAST_DATA objects in CCM (F405) or DTCM (F7), and on F7 FAST_CODE
+// functions in ITCM.  Otherwise these are no-ops.  The sections are set up
+// by initFastSections(), in sections.cpp, which loads FAST_DATA objects
+// from flash like any initialized data, so constant initializers hold.
+//
+// F4 code stays in flash: with the ART accelerator, flash runs the loop
+// about as fast as SRAM does over the S-bus, which it shares with DMA.
+
+#if defined(USE_FAST_SECTIONS)
+
+#if defined(STM32F7xx)
+#define FAST_CODE __attribute__((section(".fastcode")))
+#else
+#define FAST_CODE
+#endif
+
+#define FAST_DATA __attribute__((section(".fastdata")))
+
+#else
+
+#define FAST_CODE
+#define FAST_DATA
+
+#endif
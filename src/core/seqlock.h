@@ -0,0 +1,86 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Single-writer sequence lock, for handing a small struct from an interrupt
+// or serial-event context to the main loop.  The writer makes the sequence
+// odd while it copies the value in; a reader copies the value out and keeps
+// it only if the sequence was even and unchanged throughout.  Neither side
+// ever waits, so reads take constant time.
+template <class T>
+class SeqLock {
+
+    private:
+
+        // Attempts per read; on a single core the writer runs to completion
+        // once it has interrupted a reader, so the second attempt succeeds
+        static const uint8_t MAX_TRIES = 2;
+
+        uint32_t m_sequence;
+
+        T m_value;
+
+    public:
+
+        SeqLock(void)
+        {
+            m_sequence = 0;
+        }
+
+        void write(const T & value)
+        {
+            const auto sequence = __atomic_load_n(&m_sequence, __ATOMIC_RELAXED);
+
+            __atomic_store_n(&m_sequence, sequence + 1, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+
+            m_value = value;
+
+            __atomic_store_n(&m_sequence, sequence + 2, __ATOMIC_RELEASE);
+        }
+
+        // Leaves value alone and returns false if no consistent copy could
+        // be taken
+        bool read(T & value) const
+        {
+            for (uint8_t k=0; k<MAX_TRIES; ++k) {
+
+                const auto before = __atomic_load_n(&m_sequence, __ATOMIC_ACQUIRE);
+
+                if (before & 1) {
+                    continue;
+                }
+
+                T copy = m_value;
+
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+                if (__atomic_load_n(&m_sequence, __ATOMIC_RELAXED) == before) {
+                    value = copy;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+}; // class SeqLock
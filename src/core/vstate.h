@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <math.h>
+
 class VehicleState {
 
     public:
@@ -36,6 +38,76 @@ class VehicleState {
         float psi;
         float dpsi;
 
+        // Angular acceleration (deg/sec^2), computed once per loop from the
+        // filtered gyro for the PID controllers and estimators to share
+        float ddphi;
+        float ddtheta;
+        float ddpsi;
+
+        // Attitude quaternion from the estimator.  Leveling and the arming
+        // check work from this directly; on the vehicle, phi, theta, and psi
+        // are left alone and Euler angles are computed only for telemetry.
+        float qw;
+        float qx;
+        float qy;
+        float qz;
+
+        // Body-frame components of the unit up vector (the third row of the
+        // rotation matrix): a few multiplies, no trig.  The z component is
+        // the cosine of the total tilt and goes negative when inverted.
+        float rollTilt(void) const
+        {
+            return 2 * (qw * qx + qy * qz);
+        }
+
+        float pitchTilt(void) const
+        {
+            return 2 * (qx * qz - qw * qy);
+        }
+
+        float cosTilt(void) const
+        {
+            return qw * qw - qx * qx - qy * qy + qz * qz;
+        }
+
+        // Roll and pitch angles (radians) for leveling, from the up vector
+        // with arithmetic only.  Both are within 0.4 deg of Imu::quat2euler()
+        // out to 45 deg and exact to first order at level.  Roll spans
+        // +/-pi, so an inverted vehicle keeps its error sign; pitch has no
+        // singularity at +/-90 deg.
+        float rollAngle(void) const
+        {
+            const auto s = rollTilt();
+            const auto c = cosTilt();
+
+            const auto pi = (float)M_PI;
+
+            // atan(x) ~ x / (1 + 0.28 x^2) for |x| <= 1, on whichever of
+            // s/c and c/s is in range
+            if (fabsf(s) > fabsf(c)) {
+                const auto x = c / s;
+                return (s > 0 ? pi : -pi) / 2 - x / (1 + 0.28f * x * x);
+            }
+
+            if (c == 0) {
+                return 0;
+            }
+
+            const auto x = s / c;
+            const auto a = x / (1 + 0.28f * x * x);
+
+            return c > 0 ? a : a + (s < 0 ? -pi : pi);
+        }
+
+        // asin() of the forward component, to fifth order
+        float pitchAngle(void) const
+        {
+            const auto s = pitchTilt();
+            const auto s2 = s * s;
+
+            return s * (1 + s2 * (1 / 6.f + s2 * (3 / 40.f)));
+        }
+
         VehicleState(
                 float _x,
                 float _dx,
@@ -64,6 +136,23 @@ class VehicleState {
             dtheta = _dtheta;
             psi = _psi;
             dpsi = _dpsi;
+            ddphi = 0;
+            ddtheta = 0;
+            ddpsi = 0;
+
+            // Simulators supply Euler angles; convert them once here, with
+            // pitch sign following Imu::quat2euler()
+            const auto cr = cosf(_phi / 2);
+            const auto sr = sinf(_phi / 2);
+            const auto cp = cosf(_theta / 2);
+            const auto sp = -sinf(_theta / 2);
+            const auto cy = cosf(_psi / 2);
+            const auto sy = sinf(_psi / 2);
+
+            qw = cr * cp * cy + sr * sp * sy;
+            qx = sr * cp * cy - cr * sp * sy;
+            qy = cr * sp * cy + sr * cp * sy;
+            qz = cr * cp * sy - sr * sp * cy;
         }
 
         VehicleState(void)
@@ -85,5 +174,12 @@ class VehicleState {
             dtheta = state.dtheta;
             psi = state.psi;
             dpsi = state.dpsi;
+            ddphi = state.ddphi;
+            ddtheta = state.ddtheta;
+            ddpsi = state.ddpsi;
+            qw = state.qw;
+            qx = state.qx;
+            qy = state.qy;
+            qz = state.qz;
         }
 };
@@ -19,7 +19,7 @@
 
 #pragma once
 
-#include <vector>
+#include <stdint.h>
 
 class Esc {
 
@@ -22,34 +22,34 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#include <vector>
-
+#include "core/fixedvector.h"
+#include "core/mixer.h"
 #include "esc.h"
 
 class BrushedEsc : public Esc {
 
     private:
 
-        std::vector<uint8_t> * m_motorPins;
+        FixedVector<uint8_t, Mixer::MAX_MOTORS> m_motorPins;
 
     public:
 
-        BrushedEsc(std::vector<uint8_t> * motorPins)
+        BrushedEsc(const FixedVector<uint8_t, Mixer::MAX_MOTORS> & motorPins)
+            : m_motorPins(motorPins)
         {
-            m_motorPins = motorPins;
         }
 
         void begin(void)
         {
-            for (auto pin : *m_motorPins) {
+            for (auto pin : m_motorPins) {
                 analogWrite(pin, 0);
             }
         }
 
         virtual void write(float motorValues[]) override
         {
-            for (uint8_t k=0; k<m_motorPins->size(); ++k) {
-                analogWrite((*m_motorPins)[k], (uint8_t)(motorValues[k] * 255));
+            for (uint8_t k=0; k<m_motorPins.size(); ++k) {
+                analogWrite(m_motorPins[k], (uint8_t)(motorValues[k] * 255));
             }
         }
 }; 
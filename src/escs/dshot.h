@@ -22,8 +22,6 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#include <vector>
-
 #include <dshot_stm32.h>
 
 #include "esc.h"
@@ -32,6 +30,8 @@ class DshotEsc : public Esc {
 
     private:
 
+        // Arming waits on this; the gyro calibrates meanwhile.  Shorten it
+        // only for an ESC whose arming time has been measured.
         const uint32_t STARTUP_USEC = 5000000;
 
         Stm32Dshot * m_dshot;
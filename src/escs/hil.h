@@ -0,0 +1,55 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "esc.h"
+#include "hilprotocol.h"
+
+// Sends motor values to the hardware-in-the-loop host instead of to ESCs:
+// one MOTORS frame per SENSORS frame, from the first core-loop pass after
+// the frame arrived
+class HilEsc : public Esc {
+
+    private:
+
+        Hil * m_hil;
+
+        Stream * m_stream;
+
+    public:
+
+        HilEsc(Hil & hil, Stream & stream)
+        {
+            m_hil = &hil;
+            m_stream = &stream;
+        }
+
+        virtual void write(float motors[]) override
+        {
+            if (m_hil->setMotors(motors)) {
+
+                uint8_t frame[Hil::MOTORS_FRAME_SIZE] = {};
+
+                m_stream->write(frame, m_hil->getMotorsFrame(frame));
+            }
+        }
+};
@@ -0,0 +1,245 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Hardware-in-the-loop protocol.  The host sends a SENSORS frame for each
+// simulated sample, carrying raw gyro and accelerometer values (as the IMU
+// would report them) and SBUS receiver values; the board answers each one
+// with a MOTORS frame, echoing the sample's sequence number.  All values are
+// little-endian.  Each frame is
+//
+//     0xA5 0x5A TYPE SIZE PAYLOAD[SIZE] CRC
+//
+// where CRC is CRC-8/DVB-S2 over TYPE, SIZE and PAYLOAD.  Bytes outside a
+// valid frame are skipped, so either end can resynchronize mid-stream.
+class Hil {
+
+    public:
+
+        static const uint8_t SYNC1 = 0xA5;
+        static const uint8_t SYNC2 = 0x5A;
+
+        static const uint8_t SENSORS = 'S';
+        static const uint8_t MOTORS  = 'M';
+
+        static const uint8_t CHANNEL_COUNT = 6;
+        static const uint8_t MOTOR_COUNT = 4;
+
+        typedef struct __attribute__((packed)) {
+
+            uint16_t seq;
+            int16_t  gyro[3];
+            int16_t  accel[3];
+            uint16_t channels[CHANNEL_COUNT];
+            uint8_t  lostFrame;
+
+        } sensors_t;
+
+        typedef struct __attribute__((packed)) {
+
+            uint16_t seq;
+            uint16_t motors[MOTOR_COUNT]; // [0,1] scaled to [0,65535]
+
+        } motors_t;
+
+        static const uint8_t HEADER_SIZE = 4;
+
+        static const uint8_t MOTORS_FRAME_SIZE =
+            HEADER_SIZE + sizeof(motors_t) + 1;
+
+        static uint8_t crc8(uint8_t crc, const uint8_t c)
+        {
+            crc ^= c;
+
+            for (uint8_t k=0; k<8; ++k) {
+                crc = (crc & 0x80) ? (crc << 1) ^ 0xD5 : crc << 1;
+            }
+
+            return crc;
+        }
+
+    private:
+
+        typedef enum {
+            IDLE,
+            GOT_SYNC1,
+            GOT_SYNC2,
+            GOT_TYPE,
+            IN_PAYLOAD,
+            GOT_PAYLOAD
+        } parserState_t;
+
+        parserState_t m_parserState;
+
+        uint8_t m_type;
+        uint8_t m_size;
+        uint8_t m_index;
+        uint8_t m_crc;
+
+        sensors_t m_incoming;
+        sensors_t m_sensors;
+
+        // Aligned copy, for Stm32Board::setSbusValues()
+        uint16_t m_channels[CHANNEL_COUNT];
+
+        bool m_gotSensors;
+        bool m_replyPending;
+
+        motors_t m_motors;
+
+    public:
+
+        Hil(void)
+        {
+            memset(this, 0, sizeof(*this));
+        }
+
+        /**
+          * Returns true when a complete, valid SENSORS frame has arrived
+          */
+        bool parse(const uint8_t c)
+        {
+            bool gotSensors = false;
+
+            switch (m_parserState) {
+
+                case IDLE:
+                    m_parserState = c == SYNC1 ? GOT_SYNC1 : IDLE;
+                    break;
+
+                case GOT_SYNC1:
+                    m_parserState =
+                        c == SYNC2 ? GOT_SYNC2 : c == SYNC1 ? GOT_SYNC1 : IDLE;
+                    break;
+
+                case GOT_SYNC2:
+                    m_type = c;
+                    m_crc = crc8(0, c);
+                    m_parserState = GOT_TYPE;
+                    break;
+
+                case GOT_TYPE:
+                    m_size = c;
+                    m_index = 0;
+                    m_crc = crc8(m_crc, c);
+                    // Only SENSORS frames come to the board
+                    m_parserState =
+                        m_type == SENSORS && m_size == sizeof(sensors_t) ?
+                        IN_PAYLOAD :
+                        IDLE;
+                    break;
+
+                case IN_PAYLOAD:
+                    ((uint8_t *)&m_incoming)[m_index++] = c;
+                    m_crc = crc8(m_crc, c);
+                    m_parserState = m_index == m_size ? GOT_PAYLOAD : IN_PAYLOAD;
+                    break;
+
+                case GOT_PAYLOAD:
+                    if (c == m_crc) {
+                        memcpy(&m_sensors, &m_incoming, sizeof(sensors_t));
+                        memcpy(m_channels, m_sensors.channels,
+                                sizeof(m_channels));
+                        m_gotSensors = true;
+                        m_replyPending = true;
+                        gotSensors = true;
+                    }
+                    m_parserState = IDLE;
+                    break;
+            }
+
+            return gotSensors;
+        }
+
+        // Until the first frame arrives these report zeros, which the IMU
+        // treats as a vehicle at rest while it calibrates
+        void getRawGyro(int16_t rawGyro[3])
+        {
+            memcpy(rawGyro, m_sensors.gyro, sizeof(m_sensors.gyro));
+        }
+
+        void getRawAccel(int16_t rawAccel[3])
+        {
+            memcpy(rawAccel, m_sensors.accel, sizeof(m_sensors.accel));
+        }
+
+        uint16_t * getChannels(void)
+        {
+            return m_channels;
+        }
+
+        bool isLostFrame(void)
+        {
+            return m_sensors.lostFrame != 0;
+        }
+
+        bool gotSensors(void)
+        {
+            return m_gotSensors;
+        }
+
+        /**
+          * Stores the latest motor values.  Returns true once for each SENSORS
+          * frame, when the reply to it should be sent.
+          */
+        bool setMotors(const float motors[])
+        {
+            for (uint8_t k=0; k<MOTOR_COUNT; ++k) {
+                const auto m = motors[k] < 0 ? 0 : motors[k] > 1 ? 1 : motors[k];
+                m_motors.motors[k] = (uint16_t)(m * 65535 + 0.5f);
+            }
+
+            const auto replyPending = m_replyPending;
+
+            m_replyPending = false;
+
+            return replyPending;
+        }
+
+        /**
+          * Fills buf with a MOTORS frame answering the latest SENSORS frame
+          * and returns its size
+          */
+        uint8_t getMotorsFrame(uint8_t buf[MOTORS_FRAME_SIZE])
+        {
+            m_motors.seq = m_sensors.seq;
+
+            buf[0] = SYNC1;
+            buf[1] = SYNC2;
+            buf[2] = MOTORS;
+            buf[3] = sizeof(motors_t);
+
+            memcpy(&buf[HEADER_SIZE], &m_motors, sizeof(motors_t));
+
+            uint8_t crc = 0;
+
+            for (uint8_t k=2; k<MOTORS_FRAME_SIZE-1; ++k) {
+                crc = crc8(crc, buf[k]);
+            }
+
+            buf[MOTORS_FRAME_SIZE-1] = crc;
+
+            return MOTORS_FRAME_SIZE;
+        }
+
+}; // class Hil
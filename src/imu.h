@@ -18,11 +18,18 @@
 
 #pragma once
 
-#include "board.h"
+#include <math.h>
+
+#include <initializer_list>
+
 #include "core/axes.h"
 #include "core/constrain.h"
+#include "core/filters/chain.h"
+#include "core/filters/kalman.h"
 #include "core/filters/pt1.h"
 #include "core/pid.h"
+#include "core/quaternion.h"
+#include "core/sections.h"
 #include "core/utils.h"
 #include "core/vstate.h"
 
@@ -33,6 +40,8 @@ class Imu {
         static const uint32_t GYRO_CALIBRATION_DURATION      = 1250000;
         static const uint16_t GYRO_LPF1_DYN_MIN_HZ           = 250;
         static const uint16_t GYRO_LPF2_STATIC_HZ            = 500;
+        static const uint16_t ANGACCEL_LPF1_HZ               = 75;
+        static const uint16_t ANGACCEL_LPF2_HZ               = 150;
         static const uint8_t  MOVEMENT_CALIBRATION_THRESHOLD = 48;
 
         static float rad2deg(float rad)
@@ -93,15 +102,50 @@ class Imu {
             Stats stats[3];
         } calibration_t;
 
+    public:
+
+        typedef FilterChain<
+            Lowpass<Pt1Filter, GYRO_LPF2_STATIC_HZ>,
+            Lowpass<Pt1Filter, GYRO_LPF1_DYN_MIN_HZ>> lowpassGyroFilterChain_t;
+
+        // Adaptive filter in place of lowpass 2
+        typedef FilterChain<
+            KalmanFilter<>,
+            Lowpass<Pt1Filter, GYRO_LPF1_DYN_MIN_HZ>> kalmanGyroFilterChain_t;
+
+        // A sketch can define GYRO_FILTER_CHAIN before including Hackflight
+        // headers (or a build can pass it with -D) to use a different chain,
+        // or define USE_GYRO_KALMAN to use the adaptive one
+#if defined(GYRO_FILTER_CHAIN)
+        typedef GYRO_FILTER_CHAIN gyroFilterChain_t;
+#elif defined(USE_GYRO_KALMAN)
+        typedef kalmanGyroFilterChain_t gyroFilterChain_t;
+#else
+        typedef lowpassGyroFilterChain_t gyroFilterChain_t;
+#endif
+
+        // Further smoothing of the filtered gyro before differentiating it
+        // to get angular acceleration
+#if defined(ANGACCEL_FILTER_CHAIN)
+        typedef ANGACCEL_FILTER_CHAIN angaccelFilterChain_t;
+#else
+        typedef FilterChain<
+            Lowpass<Pt1Filter, ANGACCEL_LPF1_HZ>,
+            Lowpass<Pt1Filter, ANGACCEL_LPF2_HZ>> angaccelFilterChain_t;
+#endif
+
+    private:
+
         typedef struct {
 
             float dps;           // aligned, calibrated, scaled, unfiltered
             float dpsFiltered;   // filtered 
-            float sampleSum;     // summed samples used for downsampling
+            float dpsSmoothed;   // filtered further, for differentiating
+            float ddps;          // angular acceleration
             float zero;
 
-            Pt1Filter lowpassFilter1 = Pt1Filter(GYRO_LPF1_DYN_MIN_HZ);
-            Pt1Filter lowpassFilter2 = Pt1Filter(GYRO_LPF2_STATIC_HZ);
+            gyroFilterChain_t filters;
+            angaccelFilterChain_t angaccelFilters;
 
         } gyroAxis_t;
 
@@ -115,9 +159,13 @@ class Imu {
         gyroAxis_t m_gyroY;
         gyroAxis_t m_gyroZ;
 
-        static uint32_t calculateGyroCalibratingCycles(void)
+        // Core loop period and frequency
+        uint32_t m_period;
+        float    m_frequency;
+
+        uint32_t calculateGyroCalibratingCycles(void)
         {
-            return GYRO_CALIBRATION_DURATION / PidController::PERIOD;
+            return GYRO_CALIBRATION_DURATION / m_period;
         }
 
         void calibrateGyroAxis(int16_t rawGyro[3], gyroAxis_t & axis, const uint8_t index)
@@ -158,16 +206,6 @@ class Imu {
             --m_gyroCalibrationCyclesRemaining;
         }
 
-        void applyGyroLpf1(gyroAxis_t & axis)
-        {
-            axis.dpsFiltered = axis.lowpassFilter1.apply(axis.sampleSum);
-        }
-
-        void applyGyroLpf2(gyroAxis_t & axis)
-        {
-            axis.sampleSum = axis.lowpassFilter2.apply(axis.dps);
-        }
-
         void scaleGyro(gyroAxis_t & axis, const float adc)
         {
             axis.dps = adc * m_gyroScale; 
@@ -178,6 +216,56 @@ class Imu {
             return rawGyro[index] - axis.zero;
         }
 
+        FAST_CODE void filterGyro(int16_t rawGyro[3], VehicleState & vstate)
+        {
+            const auto calibrationComplete = m_gyroCalibrationCyclesRemaining <= 0;
+
+            static Axes _adc;
+
+            if (calibrationComplete) {
+
+                // move 16-bit gyro data into floats to avoid overflows in
+                // calculations
+
+                _adc.x = readCalibratedGyro(rawGyro, m_gyroX, 0);
+                _adc.y = readCalibratedGyro(rawGyro, m_gyroY, 1);
+                _adc.z = readCalibratedGyro(rawGyro, m_gyroZ, 2);
+
+                _adc = m_rotateFun(_adc);
+
+                scaleGyro(m_gyroX, _adc.x);
+                scaleGyro(m_gyroY, _adc.y);
+                scaleGyro(m_gyroZ, _adc.z);
+            } 
+            
+            else {
+                calibrateGyro(rawGyro);
+            }
+
+            for (auto axis : {&m_gyroX, &m_gyroY, &m_gyroZ}) {
+
+                axis->dpsFiltered = axis->filters.apply(axis->dps);
+
+                const auto smoothed =
+                    axis->angaccelFilters.apply(axis->dpsFiltered);
+
+                axis->ddps =
+                    (smoothed - axis->dpsSmoothed) * m_frequency;
+
+                axis->dpsSmoothed = smoothed;
+            }
+
+            m_gyroIsCalibrating = !calibrationComplete;
+
+            vstate.dphi   = m_gyroX.dpsFiltered; 
+            vstate.dtheta = m_gyroY.dpsFiltered; 
+            vstate.dpsi   = m_gyroZ.dpsFiltered;
+
+            vstate.ddphi   = m_gyroX.ddps;
+            vstate.ddtheta = m_gyroY.ddps;
+            vstate.ddpsi   = m_gyroZ.ddps;
+        }
+
     protected:
 
         typedef Axes (*rotateFun_t)(Axes & axes);
@@ -206,6 +294,9 @@ class Imu {
         {
             m_rotateFun = rotateFun;
             m_gyroScale = gyroScale / 32768.;
+
+            m_period = PidController::PERIOD;
+            m_frequency = 1 / PidController::DT;
         }
 
         // For software quaternion
@@ -224,45 +315,45 @@ class Imu {
         {
             accumulateGyro(m_gyroX.dpsFiltered, m_gyroY.dpsFiltered, m_gyroZ.dpsFiltered);
 
-            const auto calibrationComplete = m_gyroCalibrationCyclesRemaining <= 0;
-
-            static Axes _adc;
+            filterGyro(rawGyro, vstate);
+        }
 
-            if (calibrationComplete) {
+        // Static-dispatch version for boards that know their IMU type at
+        // compile time: the qualified call lets accumulateGyro() be inlined
+        template <class ImuT>
+        static void gyroRawToFilteredDps(
+                ImuT & imu, int16_t rawGyro[3], VehicleState & vstate)
+        {
+            Imu & base = imu;
 
-                // move 16-bit gyro data into floats to avoid overflows in
-                // calculations
+            imu.ImuT::accumulateGyro(
+                    base.m_gyroX.dpsFiltered,
+                    base.m_gyroY.dpsFiltered,
+                    base.m_gyroZ.dpsFiltered);
 
-                _adc.x = readCalibratedGyro(rawGyro, m_gyroX, 0);
-                _adc.y = readCalibratedGyro(rawGyro, m_gyroY, 1);
-                _adc.z = readCalibratedGyro(rawGyro, m_gyroZ, 2);
+            base.filterGyro(rawGyro, vstate);
+        }
 
-                _adc = m_rotateFun(_adc);
+        // Re-derives the filters for the loop rate chosen at boot, and
+        // restarts gyro calibration, whose length is counted in loops
+        void setDt(const float dt)
+        {
+            m_period = (uint32_t)(dt * 1e6f + 0.5f);
+            m_frequency = 1 / dt;
 
-                scaleGyro(m_gyroX, _adc.x);
-                scaleGyro(m_gyroY, _adc.y);
-                scaleGyro(m_gyroZ, _adc.z);
-            } 
-            
-            else {
-                calibrateGyro(rawGyro);
+            for (auto axis : {&m_gyroX, &m_gyroY, &m_gyroZ}) {
+                axis->filters.setDt(dt);
+                axis->angaccelFilters.setDt(dt);
             }
 
-            // Use gyro lowpass 2 filter for downsampling
-            applyGyroLpf2(m_gyroX);
-            applyGyroLpf2(m_gyroY);
-            applyGyroLpf2(m_gyroZ);
-
-            // Then apply lowpass 1
-            applyGyroLpf1(m_gyroX);
-            applyGyroLpf1(m_gyroY);
-            applyGyroLpf1(m_gyroZ);
-
-            m_gyroIsCalibrating = !calibrationComplete;
+            setGyroCalibrationCycles();
+        }
 
-            vstate.dphi   = m_gyroX.dpsFiltered; 
-            vstate.dtheta = m_gyroY.dpsFiltered; 
-            vstate.dpsi   = m_gyroZ.dpsFiltered;
+        // Aligned, calibrated, scaled gyro before filtering, for spectrum
+        // analysis
+        auto getUnfilteredGyro(void) -> Axes
+        {
+            return Axes(m_gyroX.dps, m_gyroY.dps, m_gyroZ.dps);
         }
 
         virtual bool gyroIsCalibrating(void)
@@ -277,13 +368,21 @@ class Imu {
 
         virtual void begin(const uint32_t clockSpeed) = 0;
 
-        virtual auto getEulerAngles(const uint32_t time) -> Axes = 0;
+        virtual auto getQuaternion(const uint32_t time) -> Quaternion = 0;
 
         virtual void updateAccelerometer(const int16_t rawAccel[3])
         {
             (void)rawAccel;
         }
 
+        // Latest accelerometer reading in g, in the vehicle frame, for the
+        // altitude estimator; false if this IMU doesn't provide one
+        virtual bool getAccelerometer(Axes & accel)
+        {
+            (void)accel;
+            return false;
+        }
+
         virtual int32_t getGyroSkew(
                 const uint32_t nextTargetCycles,
                 const int32_t desiredPeriodCycles)
@@ -294,11 +393,16 @@ class Imu {
             return skew > (desiredPeriodCycles / 2) ? skew - desiredPeriodCycles : skew;
         }
 
+        // Euler angles are needed only for telemetry, so they're computed
+        // here on request rather than on every attitude update
         static void getEulerAngles(const VehicleState & vstate, int16_t angles[3])
         {
-            angles[0] = (int16_t)(10 * rad2degi(vstate.phi));
-            angles[1] = (int16_t)(10 * rad2degi(vstate.theta));
-            angles[2] = (int16_t)rad2degi(vstate.psi);
+            const auto euler =
+                quat2euler(vstate.qw, vstate.qx, vstate.qy, vstate.qz);
+
+            angles[0] = (int16_t)(10 * rad2degi(euler.x));
+            angles[1] = (int16_t)(10 * rad2degi(euler.y));
+            angles[2] = (int16_t)rad2degi(euler.z);
         }
 
         static auto rotate0(Axes & axes) -> Axes
@@ -51,13 +51,12 @@ class LadybugImu : public Imu {
 
     public:
 
-        virtual auto getEulerAngles(const uint32_t time) -> Axes override
+        virtual auto getQuaternion(const uint32_t time) -> Quaternion override
         {
             (void)time;
 
-            Axes angles = quat2euler(qw, qx, qy, qz);
-
-            return Axes(angles.x, -angles.y, -angles.z);
+            // Negating Y and Z negates pitch and yaw, to match our frame
+            return Quaternion(qw, qx, -qy, -qz);
         }
 
         virtual void handleInterrupt(const uint32_t cycleCounter) override
@@ -23,12 +23,14 @@
 #include "core/axes.h"
 #include "core/filters/pt2.h"
 #include "core/pid.h"
+#include "core/quaternion.h"
 #include "core/vstate.h"
 #include "imu.h"
 
 class SoftQuatImu : public Imu {
 
     friend class AccelerometerTask;
+    friend class Imu;
 
     private:
 
@@ -49,29 +51,6 @@ class SoftQuatImu : public Imu {
         // short interval of ~79us
         static const uint8_t SHORT_THRESHOLD = 82 ;
 
-        class Quaternion {
-
-            public:
-
-                float w;
-                float x;
-                float y;
-                float z;
-
-                Quaternion(const float _w, const float _x, const float _y, const float _z)
-                {
-                    w = _w;
-                    x = _x;
-                    y = _y;
-                    z = _z;
-                }
-
-                Quaternion(void)
-                    : Quaternion(0, 0, 0, 0)
-                {
-                }
-        };
-
         class Fusion {
             public:
                 uint32_t time;
@@ -303,7 +282,7 @@ class SoftQuatImu : public Imu {
             m_gyroAccum.accumulate(x, y, z);
         }
 
-        virtual auto getEulerAngles(const uint32_t time) -> Axes override
+        virtual auto getQuaternion(const uint32_t time) -> Quaternion override
         {
             auto quat = mahony(
                     (time - m_fusionPrev.time) * 1e-6,
@@ -316,7 +295,7 @@ class SoftQuatImu : public Imu {
 
             m_gyroAccum.reset();
 
-            return quat2euler(quat.w, quat.x, quat.y, quat.z);
+            return quat;
         }
 
         virtual void updateAccelerometer(const int16_t rawAccel[3]) override
@@ -332,6 +311,16 @@ class SoftQuatImu : public Imu {
 
         }
 
+        virtual bool getAccelerometer(Axes & accel) override
+        {
+            accel = Axes(
+                    m_accelAxes.x * m_accelScale,
+                    m_accelAxes.y * m_accelScale,
+                    m_accelAxes.z * m_accelScale);
+
+            return true;
+        }
+
     public:
 
         SoftQuatImu(
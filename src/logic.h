@@ -18,16 +18,22 @@
 
 #include <stdint.h>
 
-#include <vector>
-
+#include "core/altitude.h"
+#include "core/boottimes.h"
+#include "core/looprate.h"
 #include "core/mixer.h"
+#include "core/sections.h"
 #include "imu.h"
+#include "parametersets.h"
 #include "scheduler.h"
+#include "storage.h"
 #include "tasks/accelerometer.h"
 #include "tasks/attitude.h"
 #include "tasks/receiver.h"
 #include "tasks/skyranger.h"
+#include "tasks/spectrum.h"
 #include "tasks/visualizer.h"
+#include "timingstore.h"
 
 class Logic {
 
@@ -50,22 +56,87 @@ class Logic {
 
         static constexpr float MAX_ARMING_ANGLE_DEG = 25;
 
+        // Timing is saved once the motors have been stopped this long, so
+        // that the flash stall doesn't interrupt ESCs that are still running
+        static const uint32_t TIMING_SAVE_IDLE_USEC = 1000000;
+
         Scheduler m_scheduler;
 
         armingStatus_e m_armingStatus;
 
         VehicleState m_vstate;
 
+        AltitudeEstimator m_altitudeEstimator;
+
         Msp m_msp;
 
+        BootTimes m_bootTimes;
+
+        LoopRate m_loopRate;
+
+        ParameterSets m_parameterSets;
+
+        TimingStore m_timingStore;
+        bool        m_timingSavePending;
+        uint32_t    m_motorsRanUsec;    // last time any motor was commanded
+
+        bool m_escReady;
+
         uint32_t m_imuInterruptCount;
 
         AccelerometerTask m_acclerometerTask; 
         AttitudeTask      m_attitudeTask;
         ReceiverTask      m_receiverTask;
         SkyrangerTask     m_skyrangerTask; 
+        SpectrumTask      m_spectrumTask;
         VisualizerTask    m_visualizerTask; 
 
+        static const uint8_t TASK_COUNT = 6;
+
+        // Dynamic tasks in a fixed order, for saving their timing
+        void getTasks(Task * tasks[TASK_COUNT])
+        {
+            tasks[0] = &m_acclerometerTask;
+            tasks[1] = &m_attitudeTask;
+            tasks[2] = &m_receiverTask;
+            tasks[3] = &m_skyrangerTask;
+            tasks[4] = &m_spectrumTask;
+            tasks[5] = &m_visualizerTask;
+        }
+
+        bool visualizerMotorsRunning(void)
+        {
+            for (uint8_t k=0; k<Mixer::MAX_MOTORS; ++k) {
+                if (m_visualizerTask.motors[k] > 0) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // Flash writes stall the CPU and the ESC output with it, so timing
+        // is saved after a disarm, once the motors have stopped
+        void saveTimingWhenIdle(const uint32_t usec)
+        {
+            if (m_armingStatus == ARMING_ARMED || visualizerMotorsRunning()) {
+                m_motorsRanUsec = usec;
+                return;
+            }
+
+            if (m_timingSavePending &&
+                    usec - m_motorsRanUsec > TIMING_SAVE_IDLE_USEC) {
+
+                Task * tasks[TASK_COUNT] = {};
+
+                getTasks(tasks);
+
+                m_timingStore.save(m_scheduler, tasks, TASK_COUNT);
+
+                m_timingSavePending = false;
+            }
+        }
+
         void checkFailsafe(const uint32_t usec)
         {
             static bool hadSignal;
@@ -92,19 +163,28 @@ class Logic {
                 auxSwitchWasOff = auxSwitchValue > 900 && auxSwitchValue < 1200;
             }
 
-            const auto maxArmingAngle = Imu::deg2rad(MAX_ARMING_ANGLE_DEG);
-
+            // Bounds the total tilt, which also rules out inverted
             const auto imuIsLevel =
-                fabsf(m_vstate.phi) < maxArmingAngle &&
-                fabsf(m_vstate.theta) < maxArmingAngle;
+                m_vstate.cosTilt() > cosf(Imu::deg2rad(MAX_ARMING_ANGLE_DEG));
 
-            const auto gyroDoneCalibrating = !imu.gyroIsCalibrating();
+            // Choosing the loop rate restarts gyro calibration
+            const auto gyroDoneCalibrating =
+                !m_loopRate.isCalibrating() && !imu.gyroIsCalibrating();
 
             const auto haveReceiverSignal = m_receiverTask.haveSignal(usec);
 
+            if (gyroDoneCalibrating) {
+                m_bootTimes.mark(BootTimes::GYRO, usec / 1000);
+            }
+
+            if (m_escReady) {
+                m_bootTimes.mark(BootTimes::ESC, usec / 1000);
+            }
+
             return
                 auxSwitchWasOff &&
                 gyroDoneCalibrating &&
+                m_escReady &&
                 imuIsLevel &&
                 m_receiverTask.throttleIsDown() &&
                 haveReceiverSignal;
@@ -133,13 +213,60 @@ class Logic {
             }
         }
 
+        bool chooseLoopRate(Imu & imu, const uint32_t coreCycles)
+        {
+            if (!m_loopRate.update(
+                        coreCycles, m_scheduler.desiredPeriodCycles)) {
+                return false;
+            }
+
+            const auto dt = m_loopRate.getDt();
+
+            imu.setDt(dt);
+            m_parameterSets.setDt(dt);
+            m_spectrumTask.setDt(dt);
+
+            m_scheduler.desiredPeriodCycles *= m_loopRate.getDivider();
+
+            return true;
+        }
+
     public:
 
-        void begin(Imu & imu, const uint32_t clockSpeed)
+        Logic(void)
+        {
+            m_armingStatus = ARMING_UNREADY;
+            m_escReady = false;
+            m_imuInterruptCount = 0;
+            m_timingSavePending = false;
+            m_motorsRanUsec = 0;
+        }
+
+        void begin(
+                Imu & imu,
+                const uint32_t clockSpeed,
+                const uint32_t msec,
+                Storage * storage=NULL)
         {
+            m_bootTimes.mark(BootTimes::START, msec);
+
+            m_parameterSets.begin(storage);
+
+            Task * tasks[TASK_COUNT] = {};
+
+            getTasks(tasks);
+
+            m_timingStore.begin(storage, m_scheduler, tasks, TASK_COUNT);
+
             imu.begin(clockSpeed);
         }
 
+        // ESCs start up while the gyro calibrates; arming waits for both
+        void setEscReady(const bool ready)
+        {
+            m_escReady = ready;
+        }
+
         armingStatus_e getArmingStatus(void)
         {
             return m_armingStatus;
@@ -148,6 +275,21 @@ class Logic {
         void updateAccelerometer(Imu & imu, const int16_t rawAccel[3])
         {
             imu.updateAccelerometer(rawAccel);
+
+            Axes accel;
+
+            m_altitudeEstimator.update(
+                    AccelerometerTask::DT,
+                    m_vstate,
+                    imu.getAccelerometer(accel) ? &accel : nullptr);
+
+            m_altitudeEstimator.get(m_vstate);
+        }
+
+        void updateBarometer(const float mbar)
+        {
+            m_altitudeEstimator.setBaroAltitude(
+                    AltitudeEstimator::pressureToAltitude(mbar));
         }
 
         void handleImuInterrupt(Imu & imu, const uint32_t cycleCounter)
@@ -158,12 +300,15 @@ class Logic {
 
         void updateArmingStatus(Imu & imu, const uint32_t usec)
         {
+            m_bootTimes.mark(BootTimes::RUNNING, usec / 1000);
+
             checkFailsafe(usec);
 
             switch (m_armingStatus) {
 
                 case ARMING_UNREADY:
                     if (safeToArm(imu, usec)) {
+                        m_bootTimes.mark(BootTimes::ARMABLE, usec / 1000);
                         m_armingStatus = ARMING_READY;
                     }
                     break;
@@ -179,16 +324,21 @@ class Logic {
 
                 case ARMING_ARMED:
                     checkArmingSwitch();
+                    if (m_armingStatus != ARMING_ARMED) {
+                        m_timingSavePending = true;
+                    }
                     break;
 
                 default: // failsafe
                     break;
             }
+
+            saveTimingWhenIdle(usec);
         }
 
-        void step(
+        FAST_CODE void step(
                 Imu & imu,
-                std::vector<PidController *> & pids,
+                PidController::list_t & pids,
                 Mixer & mixer,
                 int16_t rawGyro[3],
                 const uint32_t usec,
@@ -196,15 +346,85 @@ class Logic {
         {
             imu.gyroRawToFilteredDps(rawGyro, m_vstate);
 
+            m_spectrumTask.capture(imu.getUnfilteredGyro(), m_vstate);
+
+            Demands demands = m_receiverTask.modifyDemands();
+
+            auto pidReset = m_receiverTask.throttleIsDown();
+
+            m_parameterSets.swap();
+
+            PidController::run(
+                    pids,
+                    demands,
+                    m_vstate,
+                    m_parameterSets.active(),
+                    usec,
+                    pidReset);
+
+            mixer.getMotors(demands, motors);
+        }
+
+        // Static-dispatch version: IMU and PID controller types are known at
+        // compile time, so the whole core path can be inlined
+        template <class ImuT, class... PidT>
+        FAST_CODE void step(
+                ImuT & imu,
+                Mixer & mixer,
+                int16_t rawGyro[3],
+                const uint32_t usec,
+                float motors[],
+                PidT & ... pids)
+        {
+            Imu::gyroRawToFilteredDps(imu, rawGyro, m_vstate);
+
+            m_spectrumTask.capture(imu.getUnfilteredGyro(), m_vstate);
+
             Demands demands = m_receiverTask.modifyDemands();
 
             auto pidReset = m_receiverTask.throttleIsDown();
 
-            PidController::run(pids, demands, m_vstate, usec, pidReset);
+            m_parameterSets.swap();
+
+            PidController::run(
+                    demands,
+                    m_vstate,
+                    m_parameterSets.active(),
+                    usec,
+                    pidReset,
+                    pids...);
 
             mixer.getMotors(demands, motors);
         }
 
+        bool isLoopRateCalibrating(void)
+        {
+            return m_loopRate.isCalibrating();
+        }
+
+        // Takes the time of one pass of the core path; once the loop rate is
+        // chosen, re-derives everything that depends on it
+        void updateLoopRate(
+                Imu & imu,
+                PidController::list_t & pids,
+                const uint32_t coreCycles)
+        {
+            if (chooseLoopRate(imu, coreCycles)) {
+                PidController::setLoopDt(pids, m_loopRate.getDt());
+            }
+        }
+
+        template <class... PidT>
+        void updateLoopRate(
+                Imu & imu,
+                const uint32_t coreCycles,
+                PidT & ... pids)
+        {
+            if (chooseLoopRate(imu, coreCycles)) {
+                PidController::setLoopDt(m_loopRate.getDt(), pids...);
+            }
+        }
+
         bool isDynamicTaskReady(const uint32_t nowCycles)
         {
             return m_scheduler.isDynamicReady(nowCycles);
@@ -231,6 +451,10 @@ class Logic {
                     m_skyrangerTask.run(m_vstate);
                     break;
 
+                case Task::SPECTRUM:
+                    m_spectrumTask.run();
+                    break;
+
                 default:
                     break;
             }
@@ -267,6 +491,10 @@ class Logic {
                     m_skyrangerTask.update(usecStart, usecTaken);
                     break;
 
+                case Task::SPECTRUM:
+                    m_spectrumTask.update(usecStart, usecTaken);
+                    break;
+
                 default:
                     break;
             }
@@ -305,6 +533,11 @@ class Logic {
                             m_skyrangerTask, nowCycles);
                     break;
 
+                case Task::SPECTRUM:
+                    endCycles = m_scheduler.getAnticipatedEndCycles(
+                            m_spectrumTask, nowCycles);
+                    break;
+
                 default:
                     break;
             }
@@ -337,9 +570,10 @@ class Logic {
 
             if (m_imuInterruptCount >= _terminalGyroRateCount) {
                 // Calculate number of clock cycles on average between gyro
-                // interrupts
+                // interrupts, then run the core every divider'th one
                 uint32_t sampleCycles = nowCycles - _sampleRateStartCycles;
-                m_scheduler.desiredPeriodCycles = sampleCycles / GYRO_RATE_COUNT;
+                m_scheduler.desiredPeriodCycles =
+                    sampleCycles / GYRO_RATE_COUNT * m_loopRate.getDivider();
                 _sampleRateStartCycles = nowCycles;
                 _terminalGyroRateCount += GYRO_RATE_COUNT;
             }
@@ -349,8 +583,10 @@ class Logic {
             static uint32_t _terminalGyroLockCount;
             static int32_t _gyroSkewAccum;
 
-            auto gyroSkew =
-                imu.getGyroSkew(nextTargetCycles, m_scheduler.desiredPeriodCycles);
+            // Skew is against the gyro period, which the loop period is a
+            // multiple of
+            auto gyroSkew = imu.getGyroSkew(nextTargetCycles,
+                    m_scheduler.desiredPeriodCycles / m_loopRate.getDivider());
 
             _gyroSkewAccum += gyroSkew;
 
@@ -373,6 +609,7 @@ class Logic {
             m_receiverTask.prioritize(usec, prioritizer);
             m_attitudeTask.prioritize(usec, prioritizer);
             m_visualizerTask.prioritize(usec, prioritizer);
+            m_spectrumTask.prioritize(usec, prioritizer);
         }
 
         uint8_t mspAvailable(void)
@@ -385,10 +622,24 @@ class Logic {
             return m_msp.read();
         }
 
+        uint8_t mspRead(uint8_t dst[], const uint8_t size)
+        {
+            return m_msp.read(dst, size);
+        }
+
         bool mspParse(const uint8_t byte)
         {
             return m_visualizerTask.parse(
-                    m_vstate, m_receiverTask, m_skyrangerTask, m_msp, byte);
+                    m_vstate,
+                    m_receiverTask,
+                    m_skyrangerTask,
+                    m_spectrumTask,
+                    m_bootTimes,
+                    m_loopRate,
+                    m_parameterSets,
+                    m_armingStatus == ARMING_ARMED,
+                    m_msp,
+                    byte);
         }
 
         uint8_t skyrangerDataAvailable(void)
@@ -404,6 +655,12 @@ class Logic {
         void skyrangerParseData(const uint8_t byte)
         {
             m_skyrangerTask.parse(byte);
+
+            float range = 0;
+
+            if (m_skyrangerTask.getRange(range)) {
+                m_altitudeEstimator.setRange(range, m_vstate);
+            }
         }
 
         float * getVisualizerMotors(void)
@@ -435,8 +692,16 @@ class Logic {
         void prioritizeExtraTasks(
                 Task::prioritizer_t & prioritizer, const uint32_t usec)
         {
-            m_acclerometerTask.prioritize(usec, prioritizer);
+            prioritizeAccelerometerTask(prioritizer, usec);
             m_skyrangerTask.prioritize(usec, prioritizer);
         }
 
+        // The accelerometer task also runs the altitude estimator, so a
+        // board without an accelerometer of ours may still want it
+        void prioritizeAccelerometerTask(
+                Task::prioritizer_t & prioritizer, const uint32_t usec)
+        {
+            m_acclerometerTask.prioritize(usec, prioritizer);
+        }
+
 }; // class Logic
@@ -23,10 +23,12 @@
 
 class Msp {
 
-    private:
+    public:
 
         static const uint8_t BUF_SIZE = 128;
 
+    private:
+
         typedef enum {
             IDLE,
             GOT_START,
@@ -42,6 +44,13 @@ class Msp {
         uint8_t m_payloadChecksum;
         uint8_t m_payloadIndex;
 
+        // Incoming-message state, per instance so that several parsers can
+        // run side by side
+        uint8_t m_type;
+        uint8_t m_crc;
+        uint8_t m_size;
+        uint8_t m_index;
+
         void serialize16(const int16_t a)
         {
             serialize8(a & 0xFF);
@@ -111,6 +120,14 @@ class Msp {
             serialize16(a);
         }
 
+        void serializeFloat(const float src)
+        {
+            uint32_t a;
+            memcpy(&a, &src, 4);
+            serialize16(a & 0xFFFF);
+            serialize16((a >> 16) & 0xFFFF);
+        }
+
     public:
 
         uint8_t payload[BUF_SIZE];
@@ -123,19 +140,14 @@ class Msp {
         {
             uint8_t messageType = 0;
 
-            static uint8_t _type;
-            static uint8_t _crc;
-            static uint8_t _size;
-            static uint8_t _index;
-
             // Payload transition functions
-            _size = m_parserState == GOT_ARROW ? c : _size;
-            _index = m_parserState == IN_PAYLOAD ? _index + 1 : 0;
-            const bool isCommand = _type >= 200;
+            m_size = m_parserState == GOT_ARROW ? c : m_size;
+            m_index = m_parserState == IN_PAYLOAD ? m_index + 1 : 0;
+            const bool isCommand = m_type >= 200;
             const bool inPayload = isCommand && m_parserState == IN_PAYLOAD;
 
             // Message-type transition function
-            _type = m_parserState == GOT_SIZE ? c : _type;
+            m_type = m_parserState == GOT_SIZE ? c : m_type;
 
             // Parser state transition function (final transition below)
             m_parserState
@@ -144,27 +156,27 @@ class Msp {
                 : m_parserState == GOT_M && (c == '<' || c == '>') ? GOT_ARROW
                 : m_parserState == GOT_ARROW ? GOT_SIZE
                 : m_parserState == GOT_SIZE ? IN_PAYLOAD
-                : m_parserState == IN_PAYLOAD && _index <= _size ? IN_PAYLOAD
+                : m_parserState == IN_PAYLOAD && m_index <= m_size ? IN_PAYLOAD
                 : m_parserState == IN_PAYLOAD ? GOT_CRC
                 : m_parserState;
 
             // Checksum transition function
-            _crc 
+            m_crc 
                 = m_parserState == GOT_SIZE ?  c
-                : m_parserState == IN_PAYLOAD ? _crc ^ c
-                : m_parserState == GOT_CRC ? _crc 
+                : m_parserState == IN_PAYLOAD ? m_crc ^ c
+                : m_parserState == GOT_CRC ? m_crc 
                 : 0;
 
             // Payload accumulation
             if (inPayload) {
-                payload[_index-1] = c;
+                payload[m_index-1] = c;
             }
 
             if (m_parserState == GOT_CRC) {
 
                 // Message dispatch
-                if (_crc == c) {
-                    messageType = _type;
+                if (m_crc == c) {
+                    messageType = m_type;
                 }
 
                 m_parserState = IDLE;
@@ -187,6 +199,25 @@ class Msp {
 
         }
 
+        float parseFloat(const uint8_t index)
+        {
+            float f = 0;
+            memcpy(&f,  &payload[4*index], sizeof(float));
+            return f;
+        }
+
+        void serializeFloats(
+                const uint8_t messageType, const float src[], const uint8_t count)
+        {
+            prepareToSerializeFloats(messageType, count);
+
+            for (auto k=0; k<count; ++k) {
+                serializeFloat(src[k]);
+            }
+
+            completeSerialize();
+        }
+
         void serializeShorts(
                 const uint8_t messageType, const int16_t src[], const uint8_t count)
         {
@@ -210,4 +241,17 @@ class Msp {
             return payload[m_payloadIndex++];
         }
 
+        // Takes up to size bytes of the reply at once, for transports that
+        // send it in a single write
+        uint8_t read(uint8_t dst[], const uint8_t size)
+        {
+            uint8_t count = 0;
+
+            while (payloadSize > 0 && count < size) {
+                dst[count++] = read();
+            }
+
+            return count;
+        }
+
 }; // class Msp
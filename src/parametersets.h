@@ -0,0 +1,190 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "core/parameters.h"
+#include "storage.h"
+
+// Two parameter blocks: the core loop reads the active one while the shadow
+// one is edited (over MSP).  Committing derives the shadow's coefficients;
+// swap(), called at the top of the core loop, then makes it active with a
+// single pointer store, so the loop never sees a half-edited block.
+class ParameterSets {
+
+    private:
+
+        static const uint32_t MAGIC = 0x48465031; // "HFP1"
+
+        typedef struct {
+
+            uint32_t magic;
+            uint16_t count;
+            uint16_t checksum;
+            float    values[Parameters::COUNT];
+
+        } image_t;
+
+        static_assert(
+                Storage::PARAMETERS_ADDRESS + sizeof(image_t) <=
+                Storage::TIMING_ADDRESS,
+                "parameter image overruns the timing block");
+
+        Parameters m_sets[2];
+
+        Parameters * m_active;
+        Parameters * m_shadow;
+
+        bool m_editing;
+        bool m_pending;
+
+        Storage * m_storage;
+
+        static uint16_t checksum(const float values[])
+        {
+            return Storage::checksum(values, sizeof(float)*Parameters::COUNT);
+        }
+
+        bool load(void)
+        {
+            image_t image = {};
+
+            if (!m_storage->read(
+                        Storage::PARAMETERS_ADDRESS, &image, sizeof(image)) ||
+                    image.magic != MAGIC ||
+                    image.count != Parameters::COUNT ||
+                    image.checksum != checksum(image.values)) {
+                return false;
+            }
+
+            memcpy(m_active->values, image.values, sizeof(image.values));
+
+            m_active->derive();
+
+            return true;
+        }
+
+    public:
+
+        ParameterSets(void)
+        {
+            m_active = &m_sets[0];
+            m_shadow = &m_sets[1];
+
+            m_editing = false;
+            m_pending = false;
+
+            m_storage = NULL;
+        }
+
+        // Loads saved parameters, if any, keeping the defaults otherwise
+        bool begin(Storage * storage)
+        {
+            m_storage = storage;
+
+            return m_storage && load();
+        }
+
+        const Parameters & active(void) const
+        {
+            return *m_active;
+        }
+
+        // Core-loop boundary
+        void swap(void)
+        {
+            if (m_pending) {
+
+                auto previous = m_active;
+
+                m_active = m_shadow;
+
+                m_shadow = previous;
+
+                m_pending = false;
+            }
+        }
+
+        // Re-derives both blocks for the loop rate chosen at boot
+        void setDt(const float dt)
+        {
+            for (auto & parameters : m_sets) {
+                parameters.dt = dt;
+                parameters.derive();
+            }
+        }
+
+        // Starts (or continues) an edit of the shadow block; an edit made
+        // after commit() but before the swap holds that swap back until the
+        // next commit()
+        bool set(const uint8_t index, const float value)
+        {
+            if (index >= Parameters::COUNT) {
+                return false;
+            }
+
+            if (!m_editing && !m_pending) {
+                *m_shadow = *m_active;
+            }
+
+            m_editing = true;
+            m_pending = false;
+
+            m_shadow->values[index] = value;
+
+            return true;
+        }
+
+        // Derives the edited block's coefficients and queues it for the
+        // next swap; optionally saves it
+        bool commit(const bool persist)
+        {
+            if (!m_editing) {
+                return false;
+            }
+
+            m_shadow->derive();
+
+            m_editing = false;
+            m_pending = true;
+
+            return persist ? save(*m_shadow) : true;
+        }
+
+        bool save(const Parameters & parameters)
+        {
+            if (!m_storage) {
+                return false;
+            }
+
+            image_t image = {};
+
+            image.magic = MAGIC;
+            image.count = Parameters::COUNT;
+            memcpy(image.values, parameters.values, sizeof(image.values));
+            image.checksum = checksum(image.values);
+
+            return m_storage->write(
+                    Storage::PARAMETERS_ADDRESS, &image, sizeof(image));
+        }
+
+}; // class ParameterSets
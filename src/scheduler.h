@@ -23,9 +23,29 @@
 #include <stdint.h>
 #include <string.h>
 
+#include "core/constrain.h"
 #include "core/pid.h"
 #include "task.h"
 
+// Learning rates for the loop-start and task-guard margins, as the number of
+// steps per microsecond of adjustment.  A sketch can define these before
+// including Hackflight headers (or a build can pass them with -D).
+#if !defined(SCHEDULER_LOOP_START_DOWN_STEP)
+#define SCHEDULER_LOOP_START_DOWN_STEP 50
+#endif
+
+#if !defined(SCHEDULER_LOOP_START_UP_STEP)
+#define SCHEDULER_LOOP_START_UP_STEP 1
+#endif
+
+#if !defined(SCHEDULER_TASK_GUARD_DOWN_STEP)
+#define SCHEDULER_TASK_GUARD_DOWN_STEP 50
+#endif
+
+#if !defined(SCHEDULER_TASK_GUARD_UP_STEP)
+#define SCHEDULER_TASK_GUARD_UP_STEP 1
+#endif
+
 class Scheduler {
 
     private:
@@ -37,20 +57,24 @@ class Scheduler {
         static const uint32_t START_LOOP_MAX_US = 12;
 
         // Fraction of a us to reduce start loop wait
-        static const uint32_t START_LOOP_DOWN_STEP = 50;  
+        static const uint32_t START_LOOP_DOWN_STEP =
+            SCHEDULER_LOOP_START_DOWN_STEP;
 
         // Fraction of a us to increase start loop wait
-        static const uint32_t START_LOOP_UP_STEP = 1;   
+        static const uint32_t START_LOOP_UP_STEP =
+            SCHEDULER_LOOP_START_UP_STEP;
 
         // Add an amount to the estimate of a task duration
         static const uint32_t TASK_GUARD_MARGIN_MIN_US = 3;   
         static const uint32_t TASK_GUARD_MARGIN_MAX_US = 6;
 
         // Fraction of a us to reduce task guard margin
-        static const uint32_t TASK_GUARD_MARGIN_DOWN_STEP = 50;  
+        static const uint32_t TASK_GUARD_MARGIN_DOWN_STEP =
+            SCHEDULER_TASK_GUARD_DOWN_STEP;
 
         // Fraction of a us to increase task guard margin
-        static const uint32_t TASK_GUARD_MARGIN_UP_STEP = 1;   
+        static const uint32_t TASK_GUARD_MARGIN_UP_STEP =
+            SCHEDULER_TASK_GUARD_UP_STEP;
 
         // Add a margin to the amount of time allowed for a check function to run
         static const uint32_t CHECK_GUARD_MARGIN_US = 2 ;  
@@ -74,6 +98,15 @@ class Scheduler {
 
     public:
 
+        // Margins learned in flight, for saving across boots
+        typedef struct {
+
+            uint32_t clockRate;
+            int32_t  loopStartCycles;
+            int32_t  taskGuardCycles;
+
+        } learned_t;
+
         // These can be modified by Board
         int32_t  desiredPeriodCycles;
         uint32_t lastTargetCycles;
@@ -147,6 +180,29 @@ class Scheduler {
         {
             return m_taskGuardCycles;
         }
+
+        void getLearned(learned_t & learned)
+        {
+            learned.clockRate = m_clockRate;
+            learned.loopStartCycles = m_loopStartCycles;
+            learned.taskGuardCycles = m_taskGuardCycles;
+        }
+
+        // Margins learned at another clock rate don't apply
+        bool setLearned(const learned_t & learned)
+        {
+            if (learned.clockRate != m_clockRate) {
+                return false;
+            }
+
+            m_loopStartCycles = constrain_i32(learned.loopStartCycles,
+                    m_loopStartMinCycles, m_loopStartMaxCycles);
+
+            m_taskGuardCycles = constrain_i32(learned.taskGuardCycles,
+                    m_taskGuardMinCycles, m_taskGuardMaxCycles);
+
+            return true;
+        }
         
         bool isCoreReady(uint32_t nowCycles)
         {
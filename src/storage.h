@@ -0,0 +1,56 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Non-volatile storage for blocks of bytes: flash on the vehicle, a file
+// on a host
+class Storage {
+
+    public:
+
+        // Where each block starts
+        static const uint16_t PARAMETERS_ADDRESS = 0;
+        static const uint16_t TIMING_ADDRESS     = 128;
+
+        virtual bool read(
+                const uint16_t address, void * data, const uint16_t size) = 0;
+
+        virtual bool write(
+                const uint16_t address, const void * data, const uint16_t size) = 0;
+
+        // Fletcher-16, for validating a block
+        static uint16_t checksum(const void * data, const uint16_t size)
+        {
+            const auto bytes = (const uint8_t *)data;
+
+            uint16_t a = 0;
+            uint16_t b = 0;
+
+            for (uint16_t k=0; k<size; ++k) {
+                a = (a + bytes[k]) % 255;
+                b = (b + a) % 255;
+            }
+
+            return (b << 8) | a;
+        }
+
+}; // class Storage
@@ -0,0 +1,74 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <EEPROM.h>
+
+#include "storage.h"
+
+// Flash storage through the STM32 core's EEPROM emulation.  The buffered
+// calls erase and program the flash page once per write(), rather than once
+// per byte as EEPROM.write() would, keeping the page's other blocks.
+// Writing stalls the CPU, so do it only while disarmed.
+class EepromStorage : public Storage {
+
+    public:
+
+        virtual bool read(
+                const uint16_t address, void * data, const uint16_t size) override
+        {
+            if (address + size > E2END + 1) {
+                return false;
+            }
+
+            eeprom_buffer_fill();
+
+            auto bytes = (uint8_t *)data;
+
+            for (uint16_t k=0; k<size; ++k) {
+                bytes[k] = eeprom_buffered_read_byte(address + k);
+            }
+
+            return true;
+        }
+
+        virtual bool write(
+                const uint16_t address,
+                const void * data,
+                const uint16_t size) override
+        {
+            if (address + size > E2END + 1) {
+                return false;
+            }
+
+            eeprom_buffer_fill();
+
+            auto bytes = (const uint8_t *)data;
+
+            for (uint16_t k=0; k<size; ++k) {
+                eeprom_buffered_write_byte(address + k, bytes[k]);
+            }
+
+            eeprom_buffer_flush();
+
+            return true;
+        }
+
+}; // class EepromStorage
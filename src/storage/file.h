@@ -0,0 +1,81 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include "storage.h"
+
+// A file standing in for flash, for host builds and simulation
+class FileStorage : public Storage {
+
+    private:
+
+        const char * m_path;
+
+    public:
+
+        FileStorage(const char * path)
+        {
+            m_path = path;
+        }
+
+        virtual bool read(
+                const uint16_t address, void * data, const uint16_t size) override
+        {
+            auto fp = fopen(m_path, "rb");
+
+            if (!fp) {
+                return false;
+            }
+
+            const auto ok =
+                fseek(fp, address, SEEK_SET) == 0 &&
+                fread(data, 1, size, fp) == size;
+
+            fclose(fp);
+
+            return ok;
+        }
+
+        // Keeps the file's other blocks, creating it if need be
+        virtual bool write(
+                const uint16_t address,
+                const void * data,
+                const uint16_t size) override
+        {
+            auto fp = fopen(m_path, "r+b");
+
+            if (!fp) {
+                fp = fopen(m_path, "w+b");
+            }
+
+            if (!fp) {
+                return false;
+            }
+
+            const auto ok =
+                fseek(fp, address, SEEK_SET) == 0 &&
+                fwrite(data, 1, size, fp) == size;
+
+            return fclose(fp) == 0 && ok;
+        }
+
+}; // class FileStorage
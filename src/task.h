@@ -32,7 +32,8 @@ class Task {
             ATTITUDE,
             VISUALIZER,
             RECEIVER,
-            SKYRANGER
+            SKYRANGER,
+            SPECTRUM
         } id_e;
 
         typedef struct {
@@ -139,6 +140,17 @@ class Task {
             return m_anticipatedExecutionTime >> EXEC_TIME_SHIFT;
         }
 
+        // Scaled execution-time estimate, for saving across boots
+        uint32_t getAnticipatedExecutionTime(void)
+        {
+            return m_anticipatedExecutionTime;
+        }
+
+        void setAnticipatedExecutionTime(const uint32_t time)
+        {
+            m_anticipatedExecutionTime = time;
+        }
+
         virtual void prioritize(const uint32_t usec, prioritizer_t & prioritizer)
         {
             adjustDynamicPriority(usec);
@@ -25,6 +25,8 @@ class AccelerometerTask : public Task {
 
     public:
 
+        static constexpr float DT = 1. / SoftQuatImu::ACCEL_SAMPLE_RATE;
+
         AccelerometerTask(void)
             : Task(ACCELEROMETER, SoftQuatImu::ACCEL_SAMPLE_RATE)
         {
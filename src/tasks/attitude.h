@@ -32,11 +32,12 @@ class AttitudeTask : public Task {
 
         void run(Imu & imu, VehicleState & vstate, const uint32_t usec)
         {
-            const auto angles = imu.getEulerAngles(usec);
+            const auto quat = imu.getQuaternion(usec);
 
-            vstate.phi   = angles.x;
-            vstate.theta = angles.y;
-            vstate.psi   = angles.z;
+            vstate.qw = quat.w;
+            vstate.qx = quat.x;
+            vstate.qy = quat.y;
+            vstate.qz = quat.z;
         }
 
 }; // class AttitudeTask
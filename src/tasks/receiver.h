@@ -18,24 +18,41 @@
 
 #pragma once
 
+#include <string.h>
+
+#include "core/seqlock.h"
 #include "task.h"
 
+// Channel values arrive in serial-event context as whole frames, published
+// through a sequence lock.  The core loop takes a snapshot of the latest
+// frame on each pass, and everything else reads that snapshot, so no reader
+// sees a frame half-written.
 class ReceiverTask : public Task {
 
     private:
 
-       
         static const uint32_t TIMEOUT_USEC = 30000;
 
         static const uint8_t   THROTTLE_LOOKUP_TABLE_SIZE = 12;
         static constexpr float THROTTLE_EXPO8 = 0;
         static constexpr float THROTTLE_MID8  = 50;
 
-        float    m_channels[6];
-        bool     m_gotNewData;
+        typedef struct {
+
+            float    channels[6];
+            uint32_t usec;
+            uint32_t count;
+            bool     lostSignal;
+
+        } frame_t;
+
+        SeqLock<frame_t> m_published;
+
+        frame_t  m_frame;            // snapshot
+        uint32_t m_framesWritten;    // writer side only
+        uint32_t m_framesUsed;       // frames seen by modifyDemands()
+
         int16_t  m_lookupThrottleRc[THROTTLE_LOOKUP_TABLE_SIZE];
-        bool     m_lostSignal;
-        uint32_t m_previousFrameTimeUs;
         float    m_rawThrottle;
         float    m_rawRoll;
         float    m_rawPitch;
@@ -93,6 +110,10 @@ class ReceiverTask : public Task {
         ReceiverTask()
             : Task(RECEIVER, 33) // Hz
         {
+            memset(&m_frame, 0, sizeof(m_frame));
+
+            m_framesWritten = 0;
+            m_framesUsed = 0;
         }
 
         bool throttleIsDown(void)
@@ -102,37 +123,38 @@ class ReceiverTask : public Task {
 
         bool haveSignal(const uint32_t usec)
         {
-            return !m_lostSignal && (usec - m_lastSignaledAtUs) < TIMEOUT_USEC;
+            return m_frame.count > 0 && !m_frame.lostSignal &&
+                (usec - m_frame.usec) < TIMEOUT_USEC;
         }
 
         float getRawThrottle(void)
         {
-            return m_channels[0];
+            return m_frame.channels[0];
         }
 
         float getRawRoll(void)
         {
-            return m_channels[1];
+            return m_frame.channels[1];
         }
 
         float getRawPitch(void)
         {
-            return m_channels[2];
+            return m_frame.channels[2];
         }
 
         float getRawYaw(void)
         {
-            return m_channels[3];
+            return m_frame.channels[3];
         }
 
         float getRawAux1(void)
         {
-            return m_channels[4];
+            return m_frame.channels[4];
         }
 
         float getRawAux2(void)
         {
-            return m_channels[5];
+            return m_frame.channels[5];
         }
 
         virtual void run(void)
@@ -143,16 +165,22 @@ class ReceiverTask : public Task {
             m_rawYaw = getRawYaw();
         }
 
+        // Called from the core loop, which takes the snapshot; keeps the
+        // previous one if the writer was mid-frame
         auto modifyDemands(void) -> Demands 
         {
-            m_previousFrameTimeUs = m_gotNewData ? 0 : m_previousFrameTimeUs;
+            m_published.read(m_frame);
+
+            const auto gotNewData = m_frame.count != m_framesUsed;
+
+            m_framesUsed = m_frame.count;
 
             // Throttle [1000,2000] => [1000,2000]
             auto tmp = constrain_f_i32(m_rawThrottle, 1050, 2000);
             auto tmp2 = (uint32_t)(tmp - 1050) * 1000 / 950;
             auto commandThrottle = lookupThrottle(tmp2);
 
-            Axes rawSetpoints = m_gotNewData ?
+            Axes rawSetpoints = gotNewData ?
 
                 Axes(
                         rescaleCommand(m_rawRoll, +1),
@@ -164,15 +192,13 @@ class ReceiverTask : public Task {
 
             static Axes _axes;
 
-            if (m_gotNewData) {
+            if (gotNewData) {
 
                 _axes.x = rawSetpoints.x;
                 _axes.y = rawSetpoints.y;
                 _axes.z = rawSetpoints.z;
             }
 
-            m_gotNewData = false;
-
             return Demands(
                     constrain_f((commandThrottle - 1000) / 1000, 0, 1),
                     _axes.x,
@@ -180,6 +206,7 @@ class ReceiverTask : public Task {
                     _axes.z);
         }
 
+        // Called from serial-event context
         void setValues(
                 uint16_t channels[],
                 const uint32_t usec,
@@ -187,14 +214,17 @@ class ReceiverTask : public Task {
                 const uint16_t srcMin,
                 const uint16_t srcMax)
         {
+            frame_t frame = {};
+
             for (uint8_t k=0; k<6; ++k) {
-                m_channels[k] = convert(channels[k], srcMin, srcMax);
+                frame.channels[k] = convert(channels[k], srcMin, srcMax);
             }
 
-            m_lostSignal = lostSignal;
-            m_lastSignaledAtUs = usec;
-            m_previousFrameTimeUs = usec;
-            m_gotNewData = true;
+            frame.usec = usec;
+            frame.count = ++m_framesWritten;
+            frame.lostSignal = lostSignal;
+
+            m_published.write(frame);
         }
 
 }; // class ReceiverTask
@@ -32,6 +32,8 @@ class SkyrangerTask : public Task {
         Msp m_parser;
         Msp m_serializer;
 
+        bool m_gotRangerData;
+
     public:
 
         int16_t mocapData[2];
@@ -40,6 +42,7 @@ class SkyrangerTask : public Task {
         SkyrangerTask(void)
             : Task(SKYRANGER, 50) // Hz
         {
+            m_gotRangerData = false;
         }
 
         void run(VehicleState & vstate)
@@ -58,6 +61,7 @@ class SkyrangerTask : public Task {
                     for (uint8_t k=0; k<16; ++k) {
                         rangerData[k] = m_parser.parseShort(k);
                     }
+                    m_gotRangerData = true;
                     break;
 
                 case MSP_SET_PAA3905:
@@ -67,6 +71,38 @@ class SkyrangerTask : public Task {
             }
         }
 
+        // Distance (m) straight below, averaged over the middle zones that
+        // have a reading; true once for each new set of ranges
+        bool getRange(float & range)
+        {
+            if (!m_gotRangerData) {
+                return false;
+            }
+
+            m_gotRangerData = false;
+
+            // VL53L5 zones at the middle of its 4x4 grid
+            static const uint8_t center[4] = {5, 6, 9, 10};
+
+            uint32_t sum = 0;
+            uint8_t count = 0;
+
+            for (auto k : center) {
+                if (rangerData[k] > 0) {
+                    sum += rangerData[k];
+                    count++;
+                }
+            }
+
+            if (count == 0) {
+                return false;
+            }
+
+            range = sum / (count * 1000.f);
+
+            return true;
+        }
+
         uint8_t imuDataAvailable(void)
         {
             return m_serializer.available();
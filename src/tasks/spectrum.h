@@ -0,0 +1,190 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "core/axes.h"
+#include "core/fft.h"
+#include "core/pid.h"
+#include "core/vstate.h"
+#include "task.h"
+
+// Gyro spectrum analyzer for tuning filters in the field.  The core loop
+// hands each gyro sample to capture(), which decimates the unfiltered and
+// filtered rates on each axis into a block; once a block is full, run()
+// transforms it one bounded FFT step per invocation, so the work is spread
+// over as many scheduler slots as it needs.  Nothing is captured until the
+// visualizer first asks for a spectrum.
+class SpectrumTask : public Task {
+
+    public:
+
+        // Unfiltered X, Y, Z, then filtered X, Y, Z
+        static const uint8_t CHANNELS = 6;
+
+    private:
+
+        static const uint8_t LOG2N = 6;
+
+        // 8 kHz loop => 2 kHz sampling, 1 kHz top bin
+        static const uint8_t DECIMATION = 4;
+
+        // Weight of each new block in the displayed magnitudes
+        static constexpr float AVERAGING = 0.25;
+
+        // Largest magnitude reported, in tenths of a deg/sec
+        static const int16_t MAX_MAGNITUDE = 32767;
+
+        typedef IncrementalFft<LOG2N> fft_t;
+
+    public:
+
+        static const uint8_t BINS = fft_t::BINS;
+
+    private:
+
+        fft_t m_fft;
+
+        uint16_t m_sampleRate;
+
+        bool m_enabled;
+
+        bool m_transforming;
+
+        float m_sums[CHANNELS];
+        uint8_t m_decimationCount;
+
+        float m_samples[CHANNELS][fft_t::N];
+        uint16_t m_sampleCount;
+
+        float m_frame[BINS];
+        float m_magnitudes[CHANNELS][BINS];
+
+        uint8_t m_channel;        // being transformed
+        uint8_t m_reportChannel;  // next one sent to the visualizer
+
+    public:
+
+        SpectrumTask(void)
+            : Task(SPECTRUM, 1000) // Hz
+        {
+            m_sampleRate = 1000000 / PidController::PERIOD / DECIMATION;
+
+            m_enabled = false;
+            m_transforming = false;
+            m_decimationCount = 0;
+            m_sampleCount = 0;
+            m_channel = 0;
+            m_reportChannel = 0;
+
+            for (uint8_t c=0; c<CHANNELS; ++c) {
+                m_sums[c] = 0;
+                for (uint8_t k=0; k<BINS; ++k) {
+                    m_magnitudes[c][k] = 0;
+                }
+            }
+        }
+
+        // Follows the loop rate chosen at boot
+        void setDt(const float dt)
+        {
+            m_sampleRate = (uint16_t)(1 / (dt * DECIMATION) + 0.5f);
+        }
+
+        // Called from the core loop, so kept to a few adds per sample
+        void capture(const Axes & unfiltered, const VehicleState & vstate)
+        {
+            if (!m_enabled || m_transforming) {
+                return;
+            }
+
+            m_sums[0] += unfiltered.x;
+            m_sums[1] += unfiltered.y;
+            m_sums[2] += unfiltered.z;
+            m_sums[3] += vstate.dphi;
+            m_sums[4] += vstate.dtheta;
+            m_sums[5] += vstate.dpsi;
+
+            if (++m_decimationCount < DECIMATION) {
+                return;
+            }
+
+            for (uint8_t c=0; c<CHANNELS; ++c) {
+                m_samples[c][m_sampleCount] = m_sums[c] / DECIMATION;
+                m_sums[c] = 0;
+            }
+
+            m_decimationCount = 0;
+
+            if (++m_sampleCount == fft_t::N) {
+                m_sampleCount = 0;
+                m_channel = 0;
+                m_transforming = true;
+            }
+        }
+
+        void run(void)
+        {
+            if (!m_transforming) {
+                return;
+            }
+
+            if (m_fft.step(m_samples[m_channel], m_frame)) {
+
+                for (uint8_t k=0; k<BINS; ++k) {
+                    m_magnitudes[m_channel][k] +=
+                        AVERAGING * (m_frame[k] - m_magnitudes[m_channel][k]);
+                }
+
+                if (++m_channel == CHANNELS) {
+                    m_transforming = false;
+                }
+            }
+        }
+
+        // Competes for a slot only while there is a block to transform
+        virtual void prioritize(
+                const uint32_t usec, prioritizer_t & prioritizer) override
+        {
+            if (m_transforming) {
+                Task::prioritize(usec, prioritizer);
+            }
+        }
+
+        // Fills report with a channel number, the sample rate, and that
+        // channel's magnitudes in tenths of a deg/sec, taking the channels in
+        // turn
+        void getReport(int16_t report[BINS+2])
+        {
+            m_enabled = true;
+
+            report[0] = m_reportChannel;
+            report[1] = m_sampleRate;
+
+            for (uint8_t k=0; k<BINS; ++k) {
+                const auto m = 10 * m_magnitudes[m_reportChannel][k];
+                report[k+2] = m > MAX_MAGNITUDE ? MAX_MAGNITUDE : (int16_t)m;
+            }
+
+            m_reportChannel = (m_reportChannel + 1) % CHANNELS;
+        }
+
+}; // class SpectrumTask
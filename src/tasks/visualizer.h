@@ -21,12 +21,16 @@
 
 #include <stdint.h>
 
+#include "core/boottimes.h"
+#include "core/looprate.h"
 #include "core/mixer.h"
 #include "imu.h"
 #include "msp.h"
+#include "parametersets.h"
 #include "receiver.h"
 #include "tasks/receiver.h"
 #include "tasks/skyranger.h"
+#include "tasks/spectrum.h"
 
 class VisualizerTask : public Task {
 
@@ -59,6 +63,11 @@ class VisualizerTask : public Task {
                 VehicleState & vstate,
                 ReceiverTask & receiverTask,
                 SkyrangerTask & skyrangerTask,
+                SpectrumTask & spectrumTask,
+                BootTimes & bootTimes,
+                const LoopRate & loopRate,
+                ParameterSets & parameterSets,
+                const bool armed,
                 Msp & msp,
                 const uint8_t byte)
         {
@@ -100,6 +109,29 @@ class VisualizerTask : public Task {
                     serializeShorts(msp, 122, skyrangerTask.mocapData, 2);
                     return true;
 
+                case 123: // BOOT_TIMES
+                    serializeShorts(msp, 123, bootTimes.get(), BootTimes::COUNT);
+                    return true;
+
+                case 124: // GYRO_SPECTRUM
+                    {
+                        int16_t report[SpectrumTask::BINS+2] = {};
+                        spectrumTask.getReport(report);
+                        serializeShorts(msp, 124, report, SpectrumTask::BINS+2);
+                    }
+                    return true;
+
+                case 125: // PARAMETERS
+                    msp.serializeFloats(
+                            125,
+                            parameterSets.active().values,
+                            Parameters::COUNT);
+                    return true;
+
+                case 126: // LOOP_RATE
+                    serializeShorts(msp, 126, loopRate.get(), LoopRate::COUNT);
+                    return true;
+
                 case 214: // SET_MOTORS
                     {
                         readAndConvertMotor(msp, 0);
@@ -109,6 +141,15 @@ class VisualizerTask : public Task {
                     } 
                     break;
 
+                case 226: // SET_PARAMETER
+                    parameterSets.set(msp.parseShort(2), msp.parseFloat(0));
+                    break;
+
+                case 227: // COMMIT_PARAMETERS
+                    // Writing flash stalls the CPU, so save only on the ground
+                    parameterSets.commit(msp.parseShort(0) && !armed);
+                    break;
+
                 default:
                     break;
             }
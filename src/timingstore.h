@@ -0,0 +1,144 @@
+/*
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "scheduler.h"
+#include "storage.h"
+#include "task.h"
+
+// Scheduler timing learned in flight -- the loop-start and task-guard
+// margins, and each dynamic task's execution-time estimate -- saved on disarm
+// and restored at boot, so that the scheduler starts each flight settled
+class TimingStore {
+
+    public:
+
+        static const uint8_t MAX_TASKS = 8;
+
+    private:
+
+        static const uint32_t MAGIC = 0x48465431; // "HFT1"
+
+        typedef struct {
+
+            uint32_t magic;
+            uint16_t count;
+            uint16_t checksum;
+
+            Scheduler::learned_t scheduler;
+            uint32_t executionTimes[MAX_TASKS];
+
+        } image_t;
+
+        Storage * m_storage;
+
+        static uint16_t checksum(const image_t & image)
+        {
+            return Storage::checksum(
+                    &image.scheduler,
+                    sizeof(image) - offsetof(image_t, scheduler));
+        }
+
+        void fill(
+                image_t & image,
+                Scheduler & scheduler,
+                Task * tasks[],
+                const uint8_t count)
+        {
+            memset(&image, 0, sizeof(image));
+
+            image.magic = MAGIC;
+            image.count = count;
+
+            scheduler.getLearned(image.scheduler);
+
+            for (uint8_t k=0; k<count; ++k) {
+                image.executionTimes[k] = tasks[k]->getAnticipatedExecutionTime();
+            }
+
+            image.checksum = checksum(image);
+        }
+
+    public:
+
+        TimingStore(void)
+        {
+            m_storage = NULL;
+        }
+
+        // Restores saved timing, if any, for the tasks given in a fixed
+        // order; keeps the defaults otherwise
+        bool begin(
+                Storage * storage,
+                Scheduler & scheduler,
+                Task * tasks[],
+                const uint8_t count)
+        {
+            m_storage = storage;
+
+            image_t image = {};
+
+            if (!m_storage || count > MAX_TASKS ||
+                    !m_storage->read(
+                        Storage::TIMING_ADDRESS, &image, sizeof(image)) ||
+                    image.magic != MAGIC ||
+                    image.count != count ||
+                    image.checksum != checksum(image) ||
+                    !scheduler.setLearned(image.scheduler)) {
+                return false;
+            }
+
+            for (uint8_t k=0; k<count; ++k) {
+                tasks[k]->setAnticipatedExecutionTime(image.executionTimes[k]);
+            }
+
+            return true;
+        }
+
+        // Writing flash stalls the CPU, so call this only while disarmed
+        // with the motors stopped.  Skips the write, and so the sector
+        // erase, when the stored timing is already the same.
+        bool save(Scheduler & scheduler, Task * tasks[], const uint8_t count)
+        {
+            if (!m_storage || count > MAX_TASKS) {
+                return false;
+            }
+
+            image_t image = {};
+
+            fill(image, scheduler, tasks, count);
+
+            image_t stored = {};
+
+            if (m_storage->read(
+                        Storage::TIMING_ADDRESS, &stored, sizeof(stored)) &&
+                    memcmp(&stored, &image, sizeof(image)) == 0) {
+                return true;
+            }
+
+            return m_storage->write(
+                    Storage::TIMING_ADDRESS, &image, sizeof(image));
+        }
+
+}; // class TimingStore
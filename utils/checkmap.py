@@ -0,0 +1,236 @@
+#!/usr/bin/python3
+'''
+Checks a FASTMEM build: the core-loop objects marked FAST_DATA must be in
+.fastdata (their symbols are local, so they are read from the ELF's symbol
+table), and with --itcm (F7 builds) the core-loop functions must be in
+.fastcode, as listed in the map file.  F4 code stays in flash.  Reports
+where .fastcode and .fastdata ended up, and exits with status 1 if anything
+is missing or misplaced.
+
+Copyright (C) 2023 Simon D. Levy
+
+MIT License
+'''
+
+import re
+from argparse import ArgumentParser
+from shutil import which
+from subprocess import run
+
+# Functions marked FAST_CODE in the core path (demangled-name prefixes)
+HOT_FUNCTIONS = (
+    'Stm32Board::step',
+    'Logic::step',
+    'Imu::filterGyro',
+    'AnglePidController::modifyDemands',
+    'AnglePidController::updateCyclic',
+    'AnglePidController::updateYaw',
+    'FixedPitchMixer::fun',
+    'QuadXbfMixer::fun',
+)
+
+# Objects the examples mark FAST_DATA
+HOT_OBJECTS = ('anglePid', 'imu', 'board')
+
+FAST_SECTIONS = ('.fastcode', '.fastdata')
+
+OUTPUT_SECTION = re.compile(r'^(\.\S+)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)')
+OUTPUT_SECTION_NAME = re.compile(r'^(\.\S+)\s*$')
+ADDRESS_SIZE = re.compile(r'^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)')
+SYMBOL = re.compile(r'^\s+0x([0-9a-f]+)\s+([^=\s].*)$')
+
+
+def demangle(names, cppfilt):
+
+    if cppfilt is None:
+        return names
+
+    result = run([cppfilt], input='\n'.join(names), capture_output=True,
+                 text=True)
+
+    return result.stdout.splitlines()
+
+
+def parse(mapfile):
+    '''
+    Returns a dictionary of output sections (name => (address, size)) and
+    a list of (symbol, address, output section)
+    '''
+
+    sections = {}
+    symbols = []
+
+    current = None
+    pending = None
+
+    with open(mapfile) as f:
+
+        for line in f:
+
+            line = line.rstrip()
+
+            # Long output-section names put address and size on the next line
+            if pending is not None:
+                match = ADDRESS_SIZE.match(line)
+                if match:
+                    current = pending
+                    sections[current] = (int(match.group(1), 16),
+                                         int(match.group(2), 16))
+                pending = None
+                continue
+
+            match = OUTPUT_SECTION.match(line)
+            if match:
+                current = match.group(1)
+                sections[current] = (int(match.group(2), 16),
+                                     int(match.group(3), 16))
+                continue
+
+            match = OUTPUT_SECTION_NAME.match(line)
+            if match:
+                pending = match.group(1)
+                continue
+
+            match = SYMBOL.match(line)
+            if match and current is not None:
+                symbols.append((match.group(2), int(match.group(1), 16),
+                                current))
+
+    return sections, symbols
+
+
+def elf_objects(elf, readelf):
+    '''
+    Returns a list of (mangled name, section name) for the data objects in
+    an ELF file, local ones included
+    '''
+
+    sections = {}
+
+    result = run([readelf, '-SW', elf], capture_output=True, text=True,
+                 check=True)
+
+    for line in result.stdout.splitlines():
+        match = re.match(r'^\s*\[\s*(\d+)\]\s+(\S+)', line)
+        if match:
+            sections[match.group(1)] = match.group(2)
+
+    objects = []
+
+    result = run([readelf, '-sW', elf], capture_output=True, text=True,
+                 check=True)
+
+    for line in result.stdout.splitlines():
+        fields = line.split()
+        if len(fields) == 8 and fields[3] == 'OBJECT':
+            objects.append((fields[7], sections.get(fields[6], fields[6])))
+
+    return objects
+
+
+def check_functions(names, symbols):
+
+    failed = False
+
+    for hot in HOT_FUNCTIONS:
+
+        found = [(name, symbol[1], symbol[2])
+                 for name, symbol in zip(names, symbols)
+                 if (name.startswith(hot + '(') or name.startswith(hot + '<'))
+                 and ')::' not in name]  # skip function-local statics
+
+        if not found:
+            print('%-36s not linked' % hot)
+            continue
+
+        for name, address, section in found:
+            ok = section == '.fastcode'
+            failed = failed or not ok
+            print('%-36s 0x%08x %-10s %s' %
+                  (hot, address, section, 'ok' if ok else 'NOT IN .fastcode'))
+
+    return failed
+
+
+def check_objects(wanted, objects, cppfilt):
+
+    names = demangle([o[0] for o in objects], cppfilt)
+
+    failed = False
+
+    for hot in wanted:
+
+        found = [section for name, (_, section) in zip(names, objects)
+                 if name == hot]
+
+        if not found:
+            print('%-36s MISSING' % hot)
+            failed = True
+            continue
+
+        for section in found:
+            ok = section == '.fastdata'
+            failed = failed or not ok
+            print('%-36s %-21s %s' %
+                  (hot, section, 'ok' if ok else 'NOT IN .fastdata'))
+
+    return failed
+
+
+def main():
+
+    argparser = ArgumentParser()
+
+    argparser.add_argument('map', help='linker map file')
+
+    argparser.add_argument('elf', help='firmware ELF file')
+
+    argparser.add_argument('-c', '--cppfilt',
+                           default=which('arm-none-eabi-c++filt') or
+                           which('c++filt'),
+                           help='c++filt program for demangling')
+
+    argparser.add_argument('-r', '--readelf',
+                           default=which('arm-none-eabi-readelf') or
+                           which('readelf'),
+                           help='readelf program')
+
+    argparser.add_argument('-d', '--data', nargs='+', default=HOT_OBJECTS,
+                           help='FAST_DATA objects to look for (default: %s)'
+                           % ' '.join(HOT_OBJECTS))
+
+    argparser.add_argument('-i', '--itcm', action='store_true',
+                           help='require the core-loop functions in .fastcode')
+
+    args = argparser.parse_args()
+
+    sections, symbols = parse(args.map)
+
+    for name in FAST_SECTIONS:
+        if name in sections:
+            address, size = sections[name]
+            print('%-10s at 0x%08x, %6d bytes' % (name, address, size))
+        else:
+            print('%-10s missing' % name)
+
+    print()
+
+    failed = check_objects(args.data, elf_objects(args.elf, args.readelf),
+                           args.cppfilt)
+
+    print()
+
+    # F4 builds leave FAST_CODE empty and keep the core loop in flash
+    # (see core/sections.h)
+    if args.itcm:
+        if sections.get('.fastcode', (0, 0))[1] == 0:
+            print('.fastcode is empty: build with FASTMEM=1 for an F7')
+            failed = True
+        names = demangle([s[0] for s in symbols], args.cppfilt)
+        failed = check_functions(names, symbols) or failed
+    else:
+        print('Core-loop code stays in flash (no --itcm)')
+
+    exit(1 if failed else 0)
+
+main()
@@ -0,0 +1,459 @@
+/*
+   Parity and speed of the C++ control core (src/core) against the Rust port
+   (rust/src).  The same trace of vehicle states and stick demands goes
+   through the C++ AnglePidController, AltHoldPidController, and QuadXbfMixer
+   and through their Rust equivalents (over the C ABI in ffi/), and the
+   outputs are compared step by step.
+
+   Usage: corebench [TRACE]
+
+   TRACE holds one loop per line, as the fields of hf_sample_t in order
+   (usec, x, dx, y, dy, z, dz, phi, dphi, theta, dtheta, psi, dpsi, ddphi,
+   ddtheta, ddpsi, throttle, roll, pitch, yaw, reset), separated by spaces or
+   commas.  With no trace, a synthetic takeoff-and-maneuver trace at the PID
+   loop rate is used.
+
+   Each stage gets the same input on both sides: the controllers get the
+   trace, and the mixers get the C++ controllers' output, so a difference
+   shows up in the stage that causes it.
+
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vector>
+
+#include <core/mixers/fixedpitch/quadxbf.h>
+#include <core/parameters.h>
+#include <core/pids/angle.h>
+#include <core/pids/setpoints/althold.h>
+
+#include "ffi/hackflight_ffi.h"
+
+static const uint32_t LOOP_HZ = 1000000 / PidController::PERIOD;
+
+// Largest difference counted as a match, in demand / motor units
+static const float TOLERANCE = 1e-4;
+
+// Seconds of synthetic trace
+static const uint32_t TRACE_SEC = 10;
+
+// Timing passes over the trace
+static const uint32_t TIMING_PASSES = 20;
+
+typedef std::vector<hf_sample_t> trace_t;
+
+static float gaussian(void)
+{
+    // Box-Muller
+    const double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    const double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+// At rest with the throttle down, then a climb through the altitude-hold
+// floor into a hover, with stick inputs the body follows and gyro noise
+static void synthesize(trace_t & trace)
+{
+    const double dt = 1.0 / LOOP_HZ;
+
+    double z = 0, dz = 0;
+    double angles[3] = {};
+    double rates[3] = {};
+
+    for (uint32_t k=0; k<TRACE_SEC*LOOP_HZ; ++k) {
+
+        const double t = k * dt;
+
+        hf_sample_t sample = {};
+
+        sample.usec = (uint32_t)(t * 1e6);
+
+        sample.reset = t < 1;
+
+        sample.throttle = t < 1 ? 0 : t < 3 ? 0.7 : 0.5;
+
+        const float sticks[3] = {
+            (float)(0.3 * sin(2 * M_PI * 0.5 * t)),
+            (float)(0.2 * sin(2 * M_PI * 0.7 * t + 1)),
+            (float)(0.1 * sin(2 * M_PI * 0.3 * t + 2))
+        };
+
+        sample.roll = sticks[0];
+        sample.pitch = sticks[1];
+        sample.yaw = sticks[2];
+
+        // Vertical motion: a climb, then settling toward a hover
+        const double ddz = t < 1 ? 0 : t < 3 ? 1.5 : -dz;
+        dz += ddz * dt;
+        z += dz * dt;
+
+        float newRates[3] = {};
+        float accels[3] = {};
+
+        for (uint8_t axis=0; axis<3; ++axis) {
+
+            // Rates lag the sticks, plus noise; angular acceleration comes
+            // from the clean rate, as the IMU's comes from the filtered gyro
+            const double target = t < 1 ? 0 : 200 * sticks[axis];
+            const double accel = 20 * (target - rates[axis]);
+            const double rate = rates[axis] + accel * dt;
+
+            newRates[axis] = rate + 2 * gaussian();
+            accels[axis] = accel;
+
+            angles[axis] += rate * dt;
+            rates[axis] = rate;
+        }
+
+        sample.z = z;
+        sample.dz = dz;
+
+        sample.phi = angles[0];
+        sample.theta = angles[1];
+        sample.psi = angles[2];
+
+        sample.dphi = newRates[0];
+        sample.dtheta = newRates[1];
+        sample.dpsi = newRates[2];
+
+        sample.ddphi = accels[0];
+        sample.ddtheta = accels[1];
+        sample.ddpsi = accels[2];
+
+        trace.push_back(sample);
+    }
+}
+
+static bool load(trace_t & trace, const char * path)
+{
+    auto fp = fopen(path, "r");
+
+    if (!fp) {
+        return false;
+    }
+
+    while (true) {
+
+        hf_sample_t s = {};
+        unsigned reset = 0;
+
+        const auto count = fscanf(fp,
+                "%u%*[ ,]%f%*[ ,]%f%*[ ,]%f%*[ ,]%f%*[ ,]%f%*[ ,]%f%*[ ,]"
+                "%f%*[ ,]%f%*[ ,]%f%*[ ,]%f%*[ ,]%f%*[ ,]%f%*[ ,]"
+                "%f%*[ ,]%f%*[ ,]%f%*[ ,]"
+                "%f%*[ ,]%f%*[ ,]%f%*[ ,]%f%*[ ,]%u",
+                &s.usec, &s.x, &s.dx, &s.y, &s.dy, &s.z, &s.dz,
+                &s.phi, &s.dphi, &s.theta, &s.dtheta, &s.psi, &s.dpsi,
+                &s.ddphi, &s.ddtheta, &s.ddpsi,
+                &s.throttle, &s.roll, &s.pitch, &s.yaw, &reset);
+
+        if (count != 21) {
+            break;
+        }
+
+        s.reset = reset != 0;
+
+        trace.push_back(s);
+    }
+
+    fclose(fp);
+
+    return !trace.empty();
+}
+
+static VehicleState makeVehicleState(const hf_sample_t & s)
+{
+    // The Euler constructor wants radians for the quaternion it builds
+    const float d2r = M_PI / 180;
+
+    VehicleState vstate(s.x, s.dx, s.y, s.dy, s.z, s.dz,
+            d2r * s.phi, s.dphi, d2r * s.theta, s.dtheta, d2r * s.psi, s.dpsi);
+
+    vstate.phi = s.phi;
+    vstate.theta = s.theta;
+    vstate.psi = s.psi;
+
+    vstate.ddphi = s.ddphi;
+    vstate.ddtheta = s.ddtheta;
+    vstate.ddpsi = s.ddpsi;
+
+    return vstate;
+}
+
+// The vehicle states are made ahead of time, as the firmware's estimator
+// keeps them, so that the timings cover only the controller
+template <class P>
+static void runPid(
+        P & pid,
+        const Parameters & params,
+        const trace_t & trace,
+        const std::vector<VehicleState> & vstates,
+        std::vector<hf_demands_t> & out)
+{
+    for (uint32_t k=0; k<trace.size(); ++k) {
+
+        const auto & s = trace[k];
+
+        Demands demands(s.throttle, s.roll, s.pitch, s.yaw);
+
+        PidController::run(
+                demands, vstates[k], params, s.usec, s.reset, pid);
+
+        out[k].throttle = demands.throttle;
+        out[k].roll = demands.roll;
+        out[k].pitch = demands.pitch;
+        out[k].yaw = demands.yaw;
+    }
+}
+
+static void runMixer(
+        const std::vector<hf_demands_t> & demands,
+        std::vector<hf_motors_t> & out)
+{
+    auto mixer = QuadXbfMixer::make();
+
+    for (uint32_t k=0; k<demands.size(); ++k) {
+
+        const auto & d = demands[k];
+
+        float motors[Mixer::MAX_MOTORS] = {};
+
+        mixer.getMotors(Demands(d.throttle, d.roll, d.pitch, d.yaw), motors);
+
+        out[k].m1 = motors[0];
+        out[k].m2 = motors[1];
+        out[k].m3 = motors[2];
+        out[k].m4 = motors[3];
+    }
+}
+
+// Compares records of float fields
+template <class R>
+static void compare(
+        const char * stage,
+        const char * names[],
+        const std::vector<R> & cpp,
+        const std::vector<R> & rust,
+        const double cppNs,
+        const double rustNs)
+{
+    const uint8_t fieldCount = sizeof(R) / sizeof(float);
+
+    printf("\n%s: C++ %.1f ns/step, Rust %.1f ns/step\n",
+            stage, cppNs, rustNs);
+
+    printf("  %-9s %12s %12s  %s\n",
+            "output", "max |diff|", "at step", "first over tolerance");
+
+    for (uint8_t f=0; f<fieldCount; ++f) {
+
+        double maxDiff = 0;
+        uint32_t maxStep = 0;
+        int64_t firstStep = -1;
+
+        for (uint32_t k=0; k<cpp.size(); ++k) {
+
+            const auto a = ((const float *)&cpp[k])[f];
+            const auto b = ((const float *)&rust[k])[f];
+
+            const double diff = fabs((double)a - (double)b);
+
+            // NaN on one side only counts as a difference
+            const auto differs = diff > TOLERANCE || (isnan(a) != isnan(b));
+
+            if (differs && firstStep < 0) {
+                firstStep = k;
+            }
+
+            if (diff > maxDiff) {
+                maxDiff = diff;
+                maxStep = k;
+            }
+        }
+
+        if (firstStep < 0) {
+            printf("  %-9s %12.3g %12u  none\n", names[f], maxDiff, maxStep);
+        }
+        else {
+            printf("  %-9s %12.3g %12u  step %ld (C++ %g, Rust %g)\n",
+                    names[f], maxDiff, maxStep, (long)firstStep,
+                    ((const float *)&cpp[firstStep])[f],
+                    ((const float *)&rust[firstStep])[f]);
+        }
+    }
+}
+
+static double nsPerStep(const timespec & start, const timespec & stop,
+        const size_t steps)
+{
+    const double ns =
+        (stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec);
+
+    return ns / (TIMING_PASSES * steps);
+}
+
+// Times C++ and Rust runs of one stage, alternating passes so that neither
+// side gets a warmer machine
+template <class C, class R>
+static void timeRuns(C cppRun, R rustRun, const size_t steps,
+        double & cppNs, double & rustNs)
+{
+    timespec cppTotal = {};
+    timespec rustTotal = {};
+
+    for (uint32_t pass=0; pass<TIMING_PASSES; ++pass) {
+
+        timespec start = {}, stop = {};
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        cppRun();
+        clock_gettime(CLOCK_MONOTONIC, &stop);
+
+        cppTotal.tv_sec += stop.tv_sec - start.tv_sec;
+        cppTotal.tv_nsec += stop.tv_nsec - start.tv_nsec;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        rustRun();
+        clock_gettime(CLOCK_MONOTONIC, &stop);
+
+        rustTotal.tv_sec += stop.tv_sec - start.tv_sec;
+        rustTotal.tv_nsec += stop.tv_nsec - start.tv_nsec;
+    }
+
+    const timespec zero = {};
+
+    cppNs = nsPerStep(zero, cppTotal, steps);
+    rustNs = nsPerStep(zero, rustTotal, steps);
+}
+
+int main(int argc, char ** argv)
+{
+    trace_t trace;
+
+    if (argc > 1) {
+
+        if (!load(trace, argv[1])) {
+            fprintf(stderr, "Can't read samples from %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    else {
+
+        srand(0);
+        synthesize(trace);
+    }
+
+    const auto n = trace.size();
+
+    const Parameters params;
+
+    std::vector<VehicleState> vstates;
+
+    for (auto & sample : trace) {
+        vstates.push_back(makeVehicleState(sample));
+    }
+
+    printf("%u steps; tolerance %g; host timings, not flight-controller "
+            "cycles\n", (unsigned)n, TOLERANCE);
+
+    std::vector<hf_demands_t> cppDemands(n), rustDemands(n);
+
+    const char * demandNames[] = { "throttle", "roll", "pitch", "yaw" };
+
+    double cppNs = 0, rustNs = 0;
+
+    // Angle ------------------------------------------------------------------
+
+    auto angleCpp = [&]() {
+        // Zeroed, as the firmware's statically allocated one is
+        AnglePidController pid = AnglePidController();
+        runPid(pid, params, trace, vstates, cppDemands);
+    };
+
+    auto angleRust = [&]() {
+        auto pid = hf_angle_make(
+                params[Parameters::ANGLE_RATE_P],
+                params[Parameters::ANGLE_RATE_I],
+                params[Parameters::ANGLE_RATE_D],
+                params[Parameters::ANGLE_RATE_F],
+                params[Parameters::ANGLE_LEVEL_P]);
+        hf_pid_run(pid, trace.data(), n, rustDemands.data());
+        hf_pid_free(pid);
+    };
+
+    timeRuns(angleCpp, angleRust, n, cppNs, rustNs);
+
+    compare("AnglePidController", demandNames, cppDemands, rustDemands,
+            cppNs, rustNs);
+
+    const auto angleDemands = cppDemands;
+
+    // Altitude hold ----------------------------------------------------------
+
+    auto altHoldCpp = [&]() {
+        AltHoldPidController pid;
+        runPid(pid, params, trace, vstates, cppDemands);
+    };
+
+    auto altHoldRust = [&]() {
+        auto pid = hf_alt_hold_make(
+                params[Parameters::ALTHOLD_P],
+                params[Parameters::ALTHOLD_I]);
+        hf_pid_run(pid, trace.data(), n, rustDemands.data());
+        hf_pid_free(pid);
+    };
+
+    timeRuns(altHoldCpp, altHoldRust, n, cppNs, rustNs);
+
+    compare("AltHoldPidController", demandNames, cppDemands, rustDemands,
+            cppNs, rustNs);
+
+    // Mixer, on the C++ angle and altitude-hold output -----------------------
+
+    std::vector<hf_demands_t> mixerInput(angleDemands);
+
+    for (uint32_t k=0; k<n; ++k) {
+        mixerInput[k].throttle = cppDemands[k].throttle;
+    }
+
+    std::vector<hf_motors_t> cppMotors(n), rustMotors(n);
+
+    const char * motorNames[] = { "m1", "m2", "m3", "m4" };
+
+    auto mixerCpp = [&]() {
+        runMixer(mixerInput, cppMotors);
+    };
+
+    auto mixerRust = [&]() {
+        hf_quadxbf_run(mixerInput.data(), n, rustMotors.data());
+    };
+
+    timeRuns(mixerCpp, mixerRust, n, cppNs, rustNs);
+
+    compare("QuadXbfMixer", motorNames, cppMotors, rustMotors,
+            cppNs, rustNs);
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+/*
+   C ABI over the Hackflight Rust core (rust/src), for running it side by side
+   with the C++ core.  Each run function steps a controller or mixer over a
+   whole trace, so that timings measure the core rather than the calls.
+
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One loop's input: vehicle state (m, m/sec, deg, deg/sec, deg/sec^2), stick
+// demands (throttle in [0,1], the rest in [-1,+1]), and the PID-reset flag
+typedef struct {
+
+    uint32_t usec;
+
+    float x;
+    float dx;
+    float y;
+    float dy;
+    float z;
+    float dz;
+    float phi;
+    float dphi;
+    float theta;
+    float dtheta;
+    float psi;
+    float dpsi;
+
+    float ddphi;
+    float ddtheta;
+    float ddpsi;
+
+    float throttle;
+    float roll;
+    float pitch;
+    float yaw;
+
+    uint8_t reset;
+
+} hf_sample_t;
+
+typedef struct {
+
+    float throttle;
+    float roll;
+    float pitch;
+    float yaw;
+
+} hf_demands_t;
+
+typedef struct {
+
+    float m1;
+    float m2;
+    float m3;
+    float m4;
+
+} hf_motors_t;
+
+typedef struct hf_pid hf_pid_t;
+
+hf_pid_t * hf_angle_make(
+        float k_rate_p,
+        float k_rate_i,
+        float k_rate_d,
+        float k_rate_f,
+        float k_level_p);
+
+hf_pid_t * hf_alt_hold_make(float k_p, float k_i);
+
+void hf_pid_free(hf_pid_t * pid);
+
+// Runs the controller on each sample's demands in turn
+void hf_pid_run(
+        hf_pid_t * pid,
+        const hf_sample_t * samples,
+        size_t count,
+        hf_demands_t * demands);
+
+void hf_quadxbf_run(
+        const hf_demands_t * demands,
+        size_t count,
+        hf_motors_t * motors);
+
+#ifdef __cplusplus
+}
+#endif
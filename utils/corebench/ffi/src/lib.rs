@@ -0,0 +1,171 @@
+/*
+   C ABI over the Hackflight Rust core; see hackflight_ffi.h
+
+   Copyright (C) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under the
+   terms of the GNU General Public License as published by the Free Software
+   Foundation, either version 3 of the License, or (at your option) any later
+   version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+   PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+use std::slice;
+
+use hackflight::Demands;
+use hackflight::Mixer;
+use hackflight::VehicleState;
+use hackflight::mixers::quadxbf;
+use hackflight::pids;
+
+#[repr(C)]
+pub struct Sample {
+    usec: u32,
+    x: f32,
+    dx: f32,
+    y: f32,
+    dy: f32,
+    z: f32,
+    dz: f32,
+    phi: f32,
+    dphi: f32,
+    theta: f32,
+    dtheta: f32,
+    psi: f32,
+    dpsi: f32,
+    ddphi: f32,
+    ddtheta: f32,
+    ddpsi: f32,
+    throttle: f32,
+    roll: f32,
+    pitch: f32,
+    yaw: f32,
+    reset: u8
+}
+
+#[repr(C)]
+pub struct CDemands {
+    throttle: f32,
+    roll: f32,
+    pitch: f32,
+    yaw: f32
+}
+
+#[repr(C)]
+pub struct CMotors {
+    m1: f32,
+    m2: f32,
+    m3: f32,
+    m4: f32
+}
+
+fn state_from_sample(sample: &Sample) -> VehicleState {
+    VehicleState {
+        x: sample.x,
+        dx: sample.dx,
+        y: sample.y,
+        dy: sample.dy,
+        z: sample.z,
+        dz: sample.dz,
+        phi: sample.phi,
+        dphi: sample.dphi,
+        theta: sample.theta,
+        dtheta: sample.dtheta,
+        psi: sample.psi,
+        dpsi: sample.dpsi
+    }
+}
+
+#[no_mangle]
+pub extern "C" fn hf_angle_make(
+    k_rate_p: f32,
+    k_rate_i: f32,
+    k_rate_d: f32,
+    k_rate_f: f32,
+    k_level_p: f32) -> *mut pids::Controller {
+
+    Box::into_raw(Box::new(
+            pids::make_angle(k_rate_p, k_rate_i, k_rate_d, k_rate_f, k_level_p)))
+}
+
+#[no_mangle]
+pub extern "C" fn hf_alt_hold_make(k_p: f32, k_i: f32) -> *mut pids::Controller {
+
+    Box::into_raw(Box::new(pids::make_alt_hold(k_p, k_i)))
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn hf_pid_free(pid: *mut pids::Controller) {
+
+    if !pid.is_null() {
+        drop(Box::from_raw(pid));
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn hf_pid_run(
+    pid: *mut pids::Controller,
+    samples: *const Sample,
+    count: usize,
+    demands: *mut CDemands) {
+
+    let pid = &mut *pid;
+    let samples = slice::from_raw_parts(samples, count);
+    let demands = slice::from_raw_parts_mut(demands, count);
+
+    for (sample, out) in samples.iter().zip(demands.iter_mut()) {
+
+        let stick_demands = Demands {
+            throttle: sample.throttle,
+            roll: sample.roll,
+            pitch: sample.pitch,
+            yaw: sample.yaw
+        };
+
+        let new_demands = pids::update(
+            pid,
+            sample.usec,
+            stick_demands,
+            state_from_sample(sample),
+            sample.reset != 0);
+
+        *out = CDemands {
+            throttle: new_demands.throttle,
+            roll: new_demands.roll,
+            pitch: new_demands.pitch,
+            yaw: new_demands.yaw
+        };
+    }
+}
+
+#[no_mangle]
+pub unsafe extern "C" fn hf_quadxbf_run(
+    demands: *const CDemands,
+    count: usize,
+    motors: *mut CMotors) {
+
+    let mixer = quadxbf::QuadXbf { };
+
+    let demands = slice::from_raw_parts(demands, count);
+    let motors = slice::from_raw_parts_mut(motors, count);
+
+    for (d, out) in demands.iter().zip(motors.iter_mut()) {
+
+        let m = mixer.get_motors(&Demands {
+            throttle: d.throttle,
+            roll: d.roll,
+            pitch: d.pitch,
+            yaw: d.yaw
+        });
+
+        *out = CMotors { m1: m.m1, m2: m.m2, m3: m.m3, m4: m.m4 };
+    }
+}
@@ -0,0 +1,87 @@
+#!/usr/bin/python3
+'''
+Compares two CoreBench cycle reports (see examples/CoreBench) and flags any
+core-loop stage whose mean cycle count grew by more than a given percentage.
+Exits with status 1 if any stage regressed.
+
+Copyright (C) 2023 Simon D. Levy
+
+MIT License
+'''
+
+import re
+from argparse import ArgumentParser
+
+HEADER = re.compile(r'^(\S.*) \(cycles per iteration')
+STAGE = re.compile(r'^\s+(\S+)\s+mean\s+(\d+)\s+max\s+(\d+)')
+
+
+def parse(filename):
+    '''
+    Returns a dictionary (pass, stage) => (mean, max)
+    '''
+
+    stages = {}
+
+    label = None
+
+    with open(filename) as f:
+
+        for line in f:
+
+            match = HEADER.match(line)
+            if match:
+                label = match.group(1)
+                continue
+
+            match = STAGE.match(line)
+            if match and label is not None:
+                stages[(label, match.group(1))] = (int(match.group(2)),
+                                                   int(match.group(3)))
+
+    return stages
+
+
+def main():
+
+    argparser = ArgumentParser()
+
+    argparser.add_argument('baseline', help='report to compare against')
+
+    argparser.add_argument('current', help='report from the current build')
+
+    argparser.add_argument('-t', '--tolerance', type=float, default=5,
+                           help='allowed growth in mean cycles (percent)')
+
+    args = argparser.parse_args()
+
+    baseline = parse(args.baseline)
+    current = parse(args.current)
+
+    failed = False
+
+    for key in baseline:
+
+        label, stage = key
+
+        if key not in current:
+            print('%-18s %-10s missing' % (label, stage))
+            failed = True
+            continue
+
+        old = baseline[key][0]
+        new = current[key][0]
+
+        change = 100 * (new - old) / old if old else 0
+
+        ok = change <= args.tolerance
+
+        failed = failed or not ok
+
+        print('%-18s %-10s %6d => %6d  %+6.1f%%  %s' %
+              (label, stage, old, new, change, 'ok' if ok else 'REGRESSED'))
+
+    exit(1 if failed else 0)
+
+
+main()
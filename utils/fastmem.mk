@@ -0,0 +1,21 @@
+# Zero-wait-state memory option for the example Makefiles.
+#
+# Building with FASTMEM=1 compiles with -DUSE_FAST_SECTIONS and links with
+# the board's script from utils/ld (set LDSCRIPT before including this
+# file), writing a map file that `make checkmap` verifies.  F7 scripts put
+# the core-loop code in ITCM, which checkmap then requires.
+
+LDDIR = $(abspath $(HFLIB)/utils/ld)
+MAP = $(OBJ)/$(SKETCH).map
+
+ifeq ($(FASTMEM),1)
+FASTMEM_PROPERTY = \
+	--build-property "compiler.cpp.extra_flags=-DUSE_FAST_SECTIONS" \
+	--build-property "compiler.ldflags=-L$(LDDIR) -T$(LDDIR)/$(LDSCRIPT) -Wl,-Map=$(MAP)"
+endif
+
+ifneq ($(filter stm32f7%,$(LDSCRIPT)),)
+CHECKMAP_FLAGS += --itcm
+endif
+
+CHECKMAP = $(HFLIB)/utils/checkmap.py $(CHECKMAP_FLAGS) $(MAP) $(OBJ)/$(SKETCH).ino.elf
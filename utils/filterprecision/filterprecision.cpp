@@ -0,0 +1,213 @@
+/*
+   Host check of the compensated lowpass filters (core/filters/precise.h)
+   against the plain ones, at loop rates from 1 to 32 kHz.  For each filter,
+   cutoff, and rate it measures:
+
+      dc      error of the settled output for a constant input, which the
+              plain filters stop short of once their increments fall below
+              the precision of the state
+      bias    mean output minus mean input for a noisy input
+      floor   RMS wander of the settled output about its mean for a
+              constant input (limit cycles)
+
+   Usage: filterprecision [-v]
+
+      -v  print the measurements for the plain filters too
+
+   Exits nonzero if a compensated filter's settled error or noise floor
+   exceeds FLOOR_ULPS units in the last place of the input, or its bias
+   exceeds the plain filter's by more than BIAS_TOLERANCE.
+
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <core/filters/precise.h>
+#include <core/filters/pt1.h>
+#include <core/filters/pt2.h>
+
+static const uint32_t RATES_HZ[] = {1000, 2000, 4000, 8000, 16000, 32000};
+
+static const uint16_t CUTOFFS_HZ[] = {10, 75, 250};
+
+// A gyro rate (deg/sec) with plenty of bits below the binary point
+static const float INPUT = 1000.123f;
+
+// Noise (deg/sec RMS) on the input for the bias measurement
+static const float NOISE = 50;
+
+// Time constants to wait before measuring; enough for a PT2 as well
+static const uint32_t SETTLE_TAUS = 40;
+
+// Seconds of settled output to measure over
+static const uint32_t MEASURE_SEC = 2;
+
+static const float FLOOR_ULPS = 2;
+
+static const float BIAS_TOLERANCE = 1e-3;
+
+class Random {
+
+    private:
+
+        uint32_t m_state;
+
+    public:
+
+        Random(const uint32_t seed)
+        {
+            m_state = seed;
+        }
+
+        float uniform(void)
+        {
+            m_state = m_state * 1664525 + 1013904223;
+            return (m_state >> 8) / 16777216.f;
+        }
+
+        // Roughly Gaussian, unit variance
+        float gaussian(void)
+        {
+            return (uniform() + uniform() + uniform() + uniform() - 2) *
+                sqrtf(3);
+        }
+};
+
+typedef struct {
+
+    double dc;
+    double bias;
+    double floor;
+
+} result_t;
+
+template <class F>
+static result_t measure(const uint16_t cutoff, const uint32_t rate)
+{
+    const auto settle = (uint32_t)(SETTLE_TAUS * rate / (2 * M_PI * cutoff));
+    const auto count = MEASURE_SEC * rate;
+
+    result_t result = {};
+
+    // Constant input: settled error and wander
+    F steady(cutoff, 1.f / rate);
+
+    for (uint32_t k=0; k<settle; ++k) {
+        steady.apply(INPUT);
+    }
+
+    double sum = 0;
+    double sumSquares = 0;
+
+    for (uint32_t k=0; k<count; ++k) {
+        const double error = steady.apply(INPUT) - (double)INPUT;
+        sum += error;
+        sumSquares += error * error;
+    }
+
+    result.dc = sum / count;
+    result.floor = sqrt(fmax(sumSquares / count - result.dc * result.dc, 0));
+
+    // Noisy input: mean out minus mean in, with the same noise for every
+    // filter at a given rate
+    F noisy(cutoff, 1.f / rate);
+
+    Random random(rate);
+
+    double sumIn = 0;
+    double sumOut = 0;
+
+    for (uint32_t k=0; k<settle+count; ++k) {
+
+        const auto input = INPUT + NOISE * random.gaussian();
+        const auto output = noisy.apply(input);
+
+        if (k >= settle) {
+            sumIn += input;
+            sumOut += output;
+        }
+    }
+
+    result.bias = (sumOut - sumIn) / count;
+
+    return result;
+}
+
+static void print(
+        const char * name,
+        const uint16_t cutoff,
+        const uint32_t rate,
+        const result_t & result,
+        const char * status)
+{
+    printf("%-18s %5d %6d   %11.3e %11.3e %11.3e  %s\n",
+            name, cutoff, rate, result.dc, result.bias, result.floor, status);
+}
+
+template <class Plain, class Precise>
+static bool check(const char * plainName, const char * preciseName,
+        const bool verbose)
+{
+    // One unit in the last place of the input
+    const auto ulp = nextafterf(INPUT, 2 * INPUT) - INPUT;
+
+    bool ok = true;
+
+    for (auto cutoff : CUTOFFS_HZ) {
+
+        for (auto rate : RATES_HZ) {
+
+            const auto plain = measure<Plain>(cutoff, rate);
+            const auto precise = measure<Precise>(cutoff, rate);
+
+            const auto pass =
+                fabs(precise.dc) <= FLOOR_ULPS * ulp &&
+                precise.floor <= FLOOR_ULPS * ulp &&
+                fabs(precise.bias) <= fabs(plain.bias) + BIAS_TOLERANCE;
+
+            ok = ok && pass;
+
+            if (verbose) {
+                print(plainName, cutoff, rate, plain, "");
+            }
+
+            print(preciseName, cutoff, rate, precise, pass ? "ok" : "FAIL");
+        }
+    }
+
+    return ok;
+}
+
+int main(int argc, char ** argv)
+{
+    const auto verbose = argc > 1 && !strcmp(argv[1], "-v");
+
+    printf("filter                Hz   loop          dc        bias       "
+            "floor  (deg/sec)\n");
+
+    const auto pt1 = check<Pt1Filter, PrecisePt1Filter>(
+            "Pt1Filter", "PrecisePt1Filter", verbose);
+
+    const auto pt2 = check<Pt2Filter, PrecisePt2Filter>(
+            "Pt2Filter", "PrecisePt2Filter", verbose);
+
+    return pt1 && pt2 ? 0 : 1;
+}
@@ -0,0 +1,325 @@
+/*
+   Frequency response and group delay of the gyro and angular-acceleration
+   (D-term) filter chains, measured by running the firmware's own filter
+   classes on sine inputs at the PID loop rate.  The loop rate defaults to
+   the gyro rate; -r gives one of the lower rates that LoopRate can choose
+   at boot.  The D-term paths end in the same first difference that
+   Imu::filterGyro() uses for angular acceleration; their gain and phase
+   are reported relative to an ideal differentiator.
+
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <imu.h>
+
+typedef Imu::gyroFilterChain_t gyroChain_t;
+typedef Imu::angaccelFilterChain_t dtermChain_t;
+
+// Gyro output feeds the angular-acceleration filters ahead of the
+// derivative used by the D-term
+class GyroToDterm {
+
+    private:
+
+        gyroChain_t m_gyro;
+        dtermChain_t m_dterm;
+
+    public:
+
+        float apply(const float input)
+        {
+            return m_dterm.apply(m_gyro.apply(input));
+        }
+
+        void setDt(const float dt)
+        {
+            m_gyro.setDt(dt);
+            m_dterm.setDt(dt);
+        }
+};
+
+// Angular acceleration as Imu::filterGyro() computes it: the first
+// difference of the filtered signal, per second
+template <class F>
+class Differentiated {
+
+    private:
+
+        F m_filter;
+
+        float m_prev;
+        float m_frequency;
+
+    public:
+
+        Differentiated(void)
+        {
+            m_prev = 0;
+            m_frequency = 1e6f / PidController::PERIOD;
+        }
+
+        float apply(const float input)
+        {
+            const auto output = m_filter.apply(input);
+
+            const auto derivative = (output - m_prev) * m_frequency;
+
+            m_prev = output;
+
+            return derivative;
+        }
+
+        void setDt(const float dt)
+        {
+            m_filter.setDt(dt);
+            m_frequency = 1 / dt;
+        }
+};
+
+template <class F>
+struct isDifferentiated {
+    static const bool value = false;
+};
+
+template <class F>
+struct isDifferentiated<Differentiated<F>> {
+    static const bool value = true;
+};
+
+// LoopRate runs the core loop at the gyro rate divided by one of these
+static const uint8_t DIVIDERS[] = {1, 2, 4};
+
+static const uint32_t GYRO_HZ = 1000000 / PidController::PERIOD;
+
+static uint32_t loopHz = GYRO_HZ;
+
+// Long enough for the slowest filter in the chains to settle
+static uint32_t settleSamples(void)
+{
+    return loopHz / 2;
+}
+
+// One second, so every integer frequency has a whole number of cycles
+static uint32_t measureSamples(void)
+{
+    return loopHz;
+}
+
+static bool belowNyquist(const double freq)
+{
+    return freq <= loopHz / 2 - 2;
+}
+
+static const uint16_t FREQS[] = {
+    5, 10, 20, 30, 50, 75, 100, 150, 200, 250, 300, 400, 500, 600, 800,
+    1000, 1500, 2000, 3000, 3500
+};
+
+typedef struct {
+
+    float gainDb;
+    float phaseDeg;
+    float delayMsec;  // group delay
+
+} response_t;
+
+// Phase (radians) of a freshly constructed filter's steady-state response
+// to a unit sine at freq, relative to the input; gain goes in *gain
+template <class F>
+static double measurePhase(const double freq, double * gain=NULL)
+{
+    F filter;
+
+    filter.setDt(1.f / loopHz);
+
+    const double w = 2 * M_PI * freq / loopHz;
+
+    const auto settle = settleSamples();
+    const auto count = measureSamples();
+
+    for (uint32_t k=0; k<settle; ++k) {
+        filter.apply(sin(w * k));
+    }
+
+    double i = 0;
+    double q = 0;
+
+    for (uint32_t k=settle; k<settle+count; ++k) {
+        const auto y = filter.apply(sin(w * k));
+        i += y * sin(w * k);
+        q += y * cos(w * k);
+    }
+
+    if (gain) {
+        *gain = 2 * sqrt(i * i + q * q) / count;
+    }
+
+    return atan2(q, i);
+}
+
+template <class F>
+static response_t measure(const double freq)
+{
+    double gain = 0;
+
+    const auto phase = measurePhase<F>(freq, &gain);
+
+    // Group delay = -dphase/domega, by central difference over +/- 1 Hz
+    // (phases unwrapped relative to the center)
+    auto lo = measurePhase<F>(freq - 1) - phase;
+    auto hi = measurePhase<F>(freq + 1) - phase;
+
+    lo = remainder(lo, 2 * M_PI);
+    hi = remainder(hi, 2 * M_PI);
+
+    // An ideal differentiator has gain 2*pi*f and leads by 90 degrees;
+    // what's left is the filters' (and the difference's) own response
+    if (isDifferentiated<F>::value) {
+        gain /= 2 * M_PI * freq;
+    }
+
+    const auto lead = isDifferentiated<F>::value ? M_PI / 2 : 0;
+
+    response_t response = {};
+
+    response.gainDb = 20 * log10(gain);
+    response.phaseDeg = remainder(phase - lead, 2 * M_PI) * 180 / M_PI;
+    response.delayMsec = -(hi - lo) / (2 * M_PI * 2) * 1000;
+
+    return response;
+}
+
+template <class F>
+static float report(const char * name, const double atFreq, const bool csv)
+{
+    if (csv) {
+        for (auto freq : FREQS) {
+            if (!belowNyquist(freq)) {
+                break;
+            }
+            const auto r = measure<F>(freq);
+            printf("%s,%d,%.3f,%.2f,%.4f\n",
+                    name, freq, r.gainDb, r.phaseDeg, r.delayMsec);
+        }
+    }
+
+    else {
+
+        printf("\n%s\n\n", name);
+        printf("     Hz    gain dB   phase deg   delay ms\n");
+
+        for (auto freq : FREQS) {
+            if (!belowNyquist(freq)) {
+                break;
+            }
+            const auto r = measure<F>(freq);
+            printf("  %5d   %8.2f   %9.1f   %8.3f\n",
+                    freq, r.gainDb, r.phaseDeg, r.delayMsec);
+        }
+    }
+
+    return measure<F>(atFreq).delayMsec;
+}
+
+static void usage(const char * progname)
+{
+    fprintf(stderr,
+            "Usage: %s [-r LOOP_HZ] [-f FREQ_HZ] [-b BUDGET_MSEC] [-c]\n"
+            "  -r  core loop rate: %d, %d or %d (default %d)\n"
+            "  -f  frequency at which to check total delay (default 100)\n"
+            "  -b  delay budget in milliseconds (default 2.5)\n"
+            "  -c  print CSV (path,hz,gain_db,phase_deg,delay_ms)\n",
+            progname,
+            (int)(GYRO_HZ / DIVIDERS[0]),
+            (int)(GYRO_HZ / DIVIDERS[1]),
+            (int)(GYRO_HZ / DIVIDERS[2]),
+            (int)GYRO_HZ);
+    exit(1);
+}
+
+int main(int argc, char ** argv)
+{
+    double freq = 100;
+    double budget = 2.5;
+    bool csv = false;
+
+    for (int k=1; k<argc; ++k) {
+
+        if (!strcmp(argv[k], "-r") && k < argc-1) {
+            loopHz = atoi(argv[++k]);
+        }
+        else if (!strcmp(argv[k], "-f") && k < argc-1) {
+            freq = atof(argv[++k]);
+        }
+        else if (!strcmp(argv[k], "-b") && k < argc-1) {
+            budget = atof(argv[++k]);
+        }
+        else if (!strcmp(argv[k], "-c")) {
+            csv = true;
+        }
+        else {
+            usage(argv[0]);
+        }
+    }
+
+    bool validRate = false;
+
+    for (auto divider : DIVIDERS) {
+        validRate = validRate || loopHz == GYRO_HZ / divider;
+    }
+
+    if (!validRate) {
+        usage(argv[0]);
+    }
+
+    if (freq < 2 || !belowNyquist(freq)) {
+        fprintf(stderr, "Frequency must be between 2 and %d Hz\n",
+                (int)(loopHz / 2 - 2));
+        exit(1);
+    }
+
+    // Integer frequencies keep the measurement window to whole cycles
+    freq = round(freq);
+
+    if (!csv) {
+        printf("PID loop at %d Hz\n", (int)loopHz);
+    }
+
+    report<gyroChain_t>("gyro", freq, csv);
+    report<Differentiated<dtermChain_t>>("dterm", freq, csv);
+    const auto total =
+        report<Differentiated<GyroToDterm>>("gyro+dterm", freq, csv);
+
+    // Status goes to stderr so it doesn't end up in CSV output
+    fflush(stdout);
+
+    fprintf(stderr, "\nGyro-to-PID group delay at %d Hz: %.3f msec (budget %.3f)\n",
+            (int)freq, total, budget);
+
+    if (total > budget) {
+        fprintf(stderr, "WARNING: over budget\n");
+        return 1;
+    }
+
+    return 0;
+}
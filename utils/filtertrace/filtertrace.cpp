@@ -0,0 +1,254 @@
+/*
+   Delay, residual noise, and cost of the lowpass and adaptive (Kalman) gyro
+   filter chains on a gyro trace, using the firmware's own filter classes.
+
+   Usage: filtertrace [TRACE]
+
+   TRACE holds one gyro sample (deg/sec) per line at the PID loop rate.  With
+   no trace, synthetic calm and aggressive segments are used.
+
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vector>
+
+#include <imu.h>
+
+static const uint32_t LOOP_HZ = 1000000 / PidController::PERIOD;
+
+// Seconds per synthetic segment
+static const uint32_t SEGMENT_SEC = 2;
+
+// Largest delay searched for, in samples (10 msec)
+static const uint32_t MAX_LAG = LOOP_HZ / 100;
+
+// Window of the centered moving average used as the reference for a
+// recorded trace, in samples (2 msec)
+static const uint32_t REFERENCE_WINDOW = LOOP_HZ / 500;
+
+// Timing passes over the trace
+static const uint32_t TIMING_PASSES = 20;
+
+typedef struct {
+
+    const char * name;
+    std::vector<float> input;
+    std::vector<float> reference;  // what the filter should recover
+
+} segment_t;
+
+static float gaussian(void)
+{
+    // Box-Muller
+    const double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    const double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+// Body motion at motionHz, plus motor vibration and sensor noise that the
+// filters should remove
+static void synthesize(
+        segment_t & segment,
+        const char * name,
+        const double motionHz,
+        const double motionDps,
+        const double vibrationHz,
+        const double vibrationDps,
+        const double noiseDps)
+{
+    segment.name = name;
+
+    for (uint32_t k=0; k<SEGMENT_SEC*LOOP_HZ; ++k) {
+
+        const double t = (double)k / LOOP_HZ;
+
+        const double motion = motionDps * sin(2 * M_PI * motionHz * t);
+
+        segment.reference.push_back(motion);
+
+        segment.input.push_back(
+                motion +
+                vibrationDps * sin(2 * M_PI * vibrationHz * t) +
+                noiseDps * gaussian());
+    }
+}
+
+static bool load(segment_t & segment, const char * path)
+{
+    auto fp = fopen(path, "r");
+
+    if (!fp) {
+        return false;
+    }
+
+    float value = 0;
+    while (fscanf(fp, "%f", &value) == 1) {
+        segment.input.push_back(value);
+    }
+
+    fclose(fp);
+
+    segment.name = path;
+
+    // No ground truth for a recorded trace; compare against a zero-phase
+    // smoothing of the trace itself
+    const int n = segment.input.size();
+    const int h = REFERENCE_WINDOW / 2;
+
+    for (int k=0; k<n; ++k) {
+        double sum = 0;
+        int count = 0;
+        for (int j=k-h; j<=k+h; ++j) {
+            if (j >= 0 && j < n) {
+                sum += segment.input[j];
+                count++;
+            }
+        }
+        segment.reference.push_back(sum / count);
+    }
+
+    return n > (int)(2 * MAX_LAG);
+}
+
+typedef struct {
+
+    float delayMsec;
+    float noiseRms;
+    float nsPerSample;
+
+} result_t;
+
+template <class C>
+static result_t evaluate(const segment_t & segment)
+{
+    const uint32_t n = segment.input.size();
+
+    std::vector<float> output(n);
+
+    C chain;
+
+    for (uint32_t k=0; k<n; ++k) {
+        output[k] = chain.apply(segment.input[k]);
+    }
+
+    // Delay is the lag that best lines the output up with the reference
+    uint32_t bestLag = 0;
+    double bestCorrelation = -1e30;
+
+    for (uint32_t lag=0; lag<=MAX_LAG; ++lag) {
+        double correlation = 0;
+        for (uint32_t k=MAX_LAG; k<n; ++k) {
+            correlation += output[k] * segment.reference[k-lag];
+        }
+        if (correlation > bestCorrelation) {
+            bestCorrelation = correlation;
+            bestLag = lag;
+        }
+    }
+
+    // Noise is what remains once that delay is taken out
+    double sumSquares = 0;
+    for (uint32_t k=MAX_LAG; k<n; ++k) {
+        const double error = output[k] - segment.reference[k-bestLag];
+        sumSquares += error * error;
+    }
+
+    timespec start = {};
+    timespec stop = {};
+
+    volatile float sink = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t pass=0; pass<TIMING_PASSES; ++pass) {
+        C timed;
+        for (uint32_t k=0; k<n; ++k) {
+            sink = timed.apply(segment.input[k]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+
+    (void)sink;
+
+    const double ns =
+        (stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec);
+
+    result_t result = {};
+    result.delayMsec = 1000.0 * bestLag / LOOP_HZ;
+    result.noiseRms = sqrt(sumSquares / (n - MAX_LAG));
+    result.nsPerSample = ns / (TIMING_PASSES * n);
+
+    return result;
+}
+
+static void report(const char * chain, const result_t & result)
+{
+    printf("  %-8s %10.3f %12.3f %12.2f\n",
+            chain, result.delayMsec, result.noiseRms, result.nsPerSample);
+}
+
+int main(int argc, char ** argv)
+{
+    std::vector<segment_t> segments;
+
+    if (argc > 1) {
+
+        segment_t segment;
+
+        if (!load(segment, argv[1])) {
+            fprintf(stderr, "Can't read enough samples from %s\n", argv[1]);
+            return 1;
+        }
+
+        segments.push_back(segment);
+    }
+
+    else {
+
+        srand(0);
+
+        segment_t calm;
+        synthesize(calm, "calm", 2, 20, 250, 10, 5);
+        segments.push_back(calm);
+
+        segment_t aggressive;
+        synthesize(aggressive, "aggressive", 8, 600, 350, 40, 15);
+        segments.push_back(aggressive);
+    }
+
+    printf("Loop rate %u Hz; host timings, not flight-controller cycles\n",
+            (unsigned)LOOP_HZ);
+
+    for (auto & segment : segments) {
+
+        printf("\n%s (%u samples)\n",
+                segment.name, (unsigned)segment.input.size());
+        printf("  %-8s %10s %12s %12s\n",
+                "chain", "delay(ms)", "noise(dps)", "ns/sample");
+
+        report("lowpass", evaluate<Imu::lowpassGyroFilterChain_t>(segment));
+        report("kalman", evaluate<Imu::kalmanGyroFilterChain_t>(segment));
+    }
+
+    return 0;
+}
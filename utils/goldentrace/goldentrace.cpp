@@ -0,0 +1,748 @@
+/*
+   Golden-trace check of the core numerics.  A committed trace of raw sensor
+   and stick inputs goes through each stage of the flight path, and every
+   output is compared with the committed expected output for that stage:
+
+      gyro    Imu::gyroRawToFilteredDps(): filtered rates and angular
+              accelerations, every loop
+      fusion  SoftQuatImu accelerometer filtering and Mahony fusion: the
+              attitude quaternion at each accelerometer sample
+      angle   AnglePidController::modifyDemands(): roll, pitch, yaw demands
+              with leveling on, every loop
+      mixer   FixedPitchMixer::fun(), with the QuadXbf layout: motor values,
+              every loop
+
+   check also flies AltitudeEstimator through a synthetic climb and hover,
+   first with the rangefinder and barometer and then with the barometer
+   alone, and fails unless altitude and vertical velocity settle on the
+   truth in each hover.
+
+   The angle and mixer stages are fed the expected (golden) output of the
+   stages before them, not the current code's, so a change shows up in the
+   stage that made it and not in every stage downstream.  Fusion runs in the
+   same IMU object as the gyro stage, so it sees the current gyro filtering;
+   when both differ, look at the gyro first.
+
+   Usage: goldentrace [check | record | synthesize] [DIR]
+
+      check       compare against the traces in DIR (default: traces); exits
+                  nonzero on any difference beyond the stage's tolerance
+      record      rewrite the expected outputs from the current code, after
+                  a change that is meant to alter them
+      synthesize  write a new input trace, then record
+
+   A value matches if it is within the stage's ULP count or its absolute
+   tolerance of the expected one.  The IMU starts with its gyro already
+   calibrated (zero offsets), as the input trace has no bias, and the
+   attitude is fused at the accelerometer rate rather than the attitude-task
+   rate, to give a short trace more fusion steps.
+
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <core/altitude.h>
+#include <core/mixers/fixedpitch/quadxbf.h>
+#include <core/parameters.h>
+#include <core/pids/angle.h>
+#include <imus/softquat.h>
+
+static const uint32_t LOOP_HZ = 1000000 / PidController::PERIOD;
+
+// Loops in a synthesized trace (half a second)
+static const uint32_t LOOPS = LOOP_HZ / 2;
+
+// Level gain for the angle stage.  The default of zero skips leveling
+// altogether, which would leave the attitude out of the trace.
+static const float LEVEL_P = 3.0;
+
+// Loops per accelerometer sample, at the accelerometer task's 1 kHz
+static const uint32_t ACCEL_DIVISOR = LOOP_HZ / 1000;
+
+// Raw sensor scales of the SoftQuatImu defaults: +/-2000 deg/sec, +/-16 g
+static const float GYRO_LSB_PER_DPS = 32768 / 2000.;
+static const float ACCEL_LSB_PER_G = 32768 / 16.;
+
+typedef std::vector<std::vector<float>> table_t;
+
+typedef struct {
+
+    const char * name;
+    const char * columns;
+
+    // Per-stage tolerances: a value matches if either holds
+    uint32_t maxUlps;
+    float maxAbs;
+
+} stage_t;
+
+// In flight-path order
+static const stage_t STAGES[] = {
+    { "gyro",   "dphi dtheta dpsi ddphi ddtheta ddpsi", 16, 1e-3 },
+    { "fusion", "qw qx qy qz",                          16, 1e-6 },
+    { "angle",  "roll pitch yaw",                       16, 1e-6 },
+    { "mixer",  "m1 m2 m3 m4",                           4, 1e-6 },
+};
+
+static const uint8_t STAGE_COUNT = sizeof(STAGES) / sizeof(stage_t);
+
+static const char * INPUT_COLUMNS =
+"gx gy gz ax ay az throttle roll pitch yaw reset";
+
+// Inputs --------------------------------------------------------------------
+
+// A small generator of our own, so that the synthesized trace doesn't depend
+// on the C library's rand()
+class Random {
+
+    private:
+
+        uint32_t m_state;
+
+    public:
+
+        Random(const uint32_t seed)
+        {
+            m_state = seed;
+        }
+
+        float uniform(void)
+        {
+            m_state = m_state * 1664525 + 1013904223;
+            return (m_state >> 8) / 16777216.f;
+        }
+
+        // Roughly Gaussian, unit variance
+        float gaussian(void)
+        {
+            return (uniform() + uniform() + uniform() + uniform() - 2) *
+                sqrtf(3);
+        }
+};
+
+static int16_t clip(const float value)
+{
+    return value < -32768 ? -32768 : value > 32767 ? 32767 : (int16_t)value;
+}
+
+// Body rates (deg/sec) of the large-tilt maneuver in the second quarter
+// second: roll to 40 deg, pitch to 35, hold, roll on to 120 and back to 80
+static void maneuver(const float t, float & roll, float & pitch)
+{
+    roll = 0;
+    pitch = 0;
+
+    if (t >= 0.25f && t < 0.30f) {
+        roll = 800;
+    }
+    else if (t >= 0.30f && t < 0.35f) {
+        pitch = 700;
+    }
+    else if (t >= 0.40f && t < 0.45f) {
+        roll = 1600;
+    }
+    else if (t >= 0.475f && t < 0.50f) {
+        roll = -1600;
+    }
+}
+
+// Rests a moment with the throttle down, rolls and pitches through small
+// stick inputs, then flies a large-tilt maneuver past 90 deg of roll with
+// the sticks centered, all with motor vibration and sensor noise
+static void synthesize(table_t & inputs)
+{
+    Random random(1);
+
+    float phi = 0, theta = 0;
+
+    for (uint32_t k=0; k<LOOPS; ++k) {
+
+        const float t = (float)k / LOOP_HZ;
+
+        const auto armed = t > 0.02f;
+
+        const auto stirring = armed && t < 0.25f;
+
+        const float sticks[3] = {
+            stirring ? 0.4f * sinf(2 * M_PI * 8 * t) : 0,
+            stirring ? 0.3f * sinf(2 * M_PI * 6 * t + 1) : 0,
+            stirring ? 0.2f * sinf(2 * M_PI * 4 * t + 2) : 0
+        };
+
+        float rates[3] = {};
+        maneuver(t, rates[0], rates[1]);
+
+        float gyro[3] = {};
+
+        for (uint8_t axis=0; axis<3; ++axis) {
+            gyro[axis] = 300 * sticks[axis] + rates[axis] +
+                20 * sinf(2 * M_PI * 300 * t + axis) +
+                3 * random.gaussian();
+        }
+
+        phi += gyro[0] / LOOP_HZ * M_PI / 180;
+        theta += gyro[1] / LOOP_HZ * M_PI / 180;
+
+        // Gravity in the body frame
+        const float g[3] = {
+            -sinf(theta),
+            sinf(phi) * cosf(theta),
+            cosf(phi) * cosf(theta)
+        };
+
+        std::vector<float> row;
+
+        for (uint8_t axis=0; axis<3; ++axis) {
+            row.push_back(clip(gyro[axis] * GYRO_LSB_PER_DPS));
+        }
+
+        for (uint8_t axis=0; axis<3; ++axis) {
+            row.push_back(clip((g[axis] + 0.05f * random.gaussian()) *
+                        ACCEL_LSB_PER_G));
+        }
+
+        row.push_back(armed ? 0.5f + 0.2f * sinf(2 * M_PI * 2 * t) : 0);
+        row.push_back(sticks[0]);
+        row.push_back(sticks[1]);
+        row.push_back(sticks[2]);
+        row.push_back(!armed);
+
+        inputs.push_back(row);
+    }
+}
+
+// Stages ---------------------------------------------------------------------
+
+// Each stage takes the inputs and the golden tables of earlier stages
+
+static void runGyroAndFusion(
+        const table_t & inputs, table_t & gyro, table_t & fusion)
+{
+    // Statically allocated, as on the vehicle: zeroed, so calibration is
+    // already complete
+    static SoftQuatImu imu(Imu::rotate0);
+
+    Imu & base = imu;
+
+    for (uint32_t k=0; k<inputs.size(); ++k) {
+
+        const auto & row = inputs[k];
+
+        int16_t rawGyro[3] = {
+            (int16_t)row[0], (int16_t)row[1], (int16_t)row[2]
+        };
+
+        VehicleState vstate;
+
+        base.gyroRawToFilteredDps(rawGyro, vstate);
+
+        gyro.push_back({ vstate.dphi, vstate.dtheta, vstate.dpsi,
+                vstate.ddphi, vstate.ddtheta, vstate.ddpsi });
+
+        if ((k + 1) % ACCEL_DIVISOR == 0) {
+
+            const int16_t rawAccel[3] = {
+                (int16_t)row[3], (int16_t)row[4], (int16_t)row[5]
+            };
+
+            base.updateAccelerometer(rawAccel);
+
+            const auto quat =
+                base.getQuaternion((k + 1) * PidController::PERIOD);
+
+            fusion.push_back({ quat.w, quat.x, quat.y, quat.z });
+        }
+    }
+}
+
+static void runAngle(
+        const table_t & inputs,
+        const table_t & gyro,
+        const table_t & fusion,
+        table_t & angle)
+{
+    static AnglePidController pid;
+
+    Parameters params;
+    params.values[Parameters::ANGLE_LEVEL_P] = LEVEL_P;
+
+    VehicleState vstate;
+
+    vstate.qw = 1;
+
+    for (uint32_t k=0; k<inputs.size(); ++k) {
+
+        const auto & row = inputs[k];
+
+        vstate.dphi = gyro[k][0];
+        vstate.dtheta = gyro[k][1];
+        vstate.dpsi = gyro[k][2];
+        vstate.ddphi = gyro[k][3];
+        vstate.ddtheta = gyro[k][4];
+        vstate.ddpsi = gyro[k][5];
+
+        Demands demands(row[6], row[7], row[8], row[9]);
+
+        PidController::run(
+                demands,
+                vstate,
+                params,
+                (k + 1) * PidController::PERIOD,
+                row[10] != 0,
+                pid);
+
+        angle.push_back({ demands.roll, demands.pitch, demands.yaw });
+
+        // The attitude seen from the next loop on
+        if ((k + 1) % ACCEL_DIVISOR == 0) {
+            const auto & q = fusion[(k + 1) / ACCEL_DIVISOR - 1];
+            vstate.qw = q[0];
+            vstate.qx = q[1];
+            vstate.qy = q[2];
+            vstate.qz = q[3];
+        }
+    }
+}
+
+static void runMixer(
+        const table_t & inputs, const table_t & angle, table_t & mixer)
+{
+    auto quadxbf = QuadXbfMixer::make();
+
+    for (uint32_t k=0; k<inputs.size(); ++k) {
+
+        Demands demands(inputs[k][6], angle[k][0], angle[k][1], angle[k][2]);
+
+        float motors[Mixer::MAX_MOTORS] = {};
+
+        quadxbf.getMotors(demands, motors);
+
+        mixer.push_back({ motors[0], motors[1], motors[2], motors[3] });
+    }
+}
+
+// Runs all stages, the angle and mixer stages on the golden output of the
+// ones before them
+static void runStages(
+        const table_t & inputs, const table_t golden[], table_t actual[])
+{
+    runGyroAndFusion(inputs, actual[0], actual[1]);
+    runAngle(inputs, golden[0], golden[1], actual[2]);
+    runMixer(inputs, golden[2], actual[3]);
+}
+
+// Files ----------------------------------------------------------------------
+
+static std::string path(const char * dir, const char * name)
+{
+    return std::string(dir) + "/" + name + ".txt";
+}
+
+static bool save(const std::string & filename, const char * columns,
+        const table_t & table)
+{
+    auto fp = fopen(filename.c_str(), "w");
+
+    if (!fp) {
+        perror(filename.c_str());
+        return false;
+    }
+
+    fprintf(fp, "# %s\n", columns);
+
+    // Nine significant digits bring a float back exactly
+    for (auto & row : table) {
+        for (uint32_t j=0; j<row.size(); ++j) {
+            fprintf(fp, j ? " %.9g" : "%.9g", row[j]);
+        }
+        fprintf(fp, "\n");
+    }
+
+    fclose(fp);
+
+    return true;
+}
+
+static bool load(const std::string & filename, table_t & table)
+{
+    auto fp = fopen(filename.c_str(), "r");
+
+    if (!fp) {
+        perror(filename.c_str());
+        return false;
+    }
+
+    char line[1024] = {};
+
+    while (fgets(line, sizeof(line), fp)) {
+
+        if (line[0] == '#') {
+            continue;
+        }
+
+        std::vector<float> row;
+
+        char * p = line;
+
+        while (true) {
+            char * end = nullptr;
+            const float value = strtof(p, &end);
+            if (end == p) {
+                break;
+            }
+            row.push_back(value);
+            p = end;
+        }
+
+        if (!row.empty()) {
+            table.push_back(row);
+        }
+    }
+
+    fclose(fp);
+
+    return true;
+}
+
+// Comparison -----------------------------------------------------------------
+
+static uint32_t ulps(const float a, const float b)
+{
+    int32_t ia = 0, ib = 0;
+    memcpy(&ia, &a, 4);
+    memcpy(&ib, &b, 4);
+
+    // Map the sign-magnitude bit patterns onto a monotonic integer line
+    const int64_t la = ia < 0 ? (int64_t)INT32_MIN - ia : ia;
+    const int64_t lb = ib < 0 ? (int64_t)INT32_MIN - ib : ib;
+
+    const int64_t d = la > lb ? la - lb : lb - la;
+
+    return d > UINT32_MAX ? UINT32_MAX : (uint32_t)d;
+}
+
+// Returns true if the stage matches
+static bool compare(
+        const stage_t & stage, const table_t & expected, const table_t & actual)
+{
+    if (expected.size() != actual.size()) {
+        printf("  %-7s FAIL  %u rows expected, %u computed\n", stage.name,
+                (unsigned)expected.size(), (unsigned)actual.size());
+        return false;
+    }
+
+    uint32_t maxUlps = 0;
+    float maxAbs = 0;
+    int64_t firstRow = -1;
+    uint32_t firstCol = 0;
+
+    for (uint32_t k=0; k<expected.size(); ++k) {
+
+        for (uint32_t j=0; j<expected[k].size(); ++j) {
+
+            const auto e = expected[k][j];
+            const auto a = actual[k][j];
+
+            const auto u = ulps(e, a);
+            const auto d = fabsf(e - a);
+
+            maxUlps = u > maxUlps ? u : maxUlps;
+            maxAbs = d > maxAbs ? d : maxAbs;
+
+            const auto matches =
+                (u <= stage.maxUlps || d <= stage.maxAbs) && !isnan(a);
+
+            if (!matches && firstRow < 0) {
+                firstRow = k;
+                firstCol = j;
+            }
+        }
+    }
+
+    printf("  %-7s %-4s  %5u rows  max %10u ulp  max %10.3g abs",
+            stage.name, firstRow < 0 ? "ok" : "FAIL",
+            (unsigned)expected.size(), maxUlps, maxAbs);
+
+    if (firstRow >= 0) {
+
+        // Column name from the stage's column list
+        char columns[256] = {};
+        strncpy(columns, stage.columns, sizeof(columns) - 1);
+        char * name = strtok(columns, " ");
+        for (uint32_t j=0; j<firstCol && name; ++j) {
+            name = strtok(nullptr, " ");
+        }
+
+        printf("\n          first at row %ld, %s: expected %.9g, got %.9g",
+                (long)firstRow, name ? name : "?",
+                expected[firstRow][firstCol], actual[firstRow][firstCol]);
+    }
+
+    printf("\n");
+
+    return firstRow < 0;
+}
+
+// Altitude -------------------------------------------------------------------
+
+// AltitudeEstimator has no golden trace; instead it is flown through a
+// synthetic climb, hover, climb out of rangefinder view and hover again,
+// tilted and with a biased, noisy accelerometer, and each hover must settle
+// on the true altitude and zero velocity.
+
+static const float ALT_DT = 1 / 1000.f;  // accelerometer task rate
+
+static const float RANGE_PERIOD = 0.02;  // sec
+static const float BARO_PERIOD  = 0.04;
+
+static const float BARO_OFFSET = 120;   // m, pressure altitude of the ground
+
+typedef struct {
+
+    const char * name;
+    float end;          // sec
+    float zTolerance;   // m, over the last second
+    float dzTolerance;  // m/sec
+
+} hover_t;
+
+static const hover_t HOVERS[] = {
+    {"range", 12, 0.02, 0.03},
+    {"baro",  30, 0.25, 0.10},
+};
+
+// Altitude, vertical velocity and acceleration at time t: rest, climb to
+// 2 m, hover, climb to 8 m (out of rangefinder view), hover
+static void altitudeProfile(
+        const float t, float & z, float & dz, float & ddz)
+{
+    // Half-cosine climb from z0 by dzTotal over [t0, t0 + 4]
+    auto climb = [&](const float t0, const float z0, const float dzTotal) {
+        const auto w = (float)M_PI / 4;
+        const auto a = w * (t - t0);
+        z = z0 + dzTotal / 2 * (1 - cosf(a));
+        dz = dzTotal / 2 * w * sinf(a);
+        ddz = dzTotal / 2 * w * w * cosf(a);
+    };
+
+    z = dz = ddz = 0;
+
+    if (t >= 2 && t < 6) {
+        climb(2, 0, 2);
+    }
+
+    else if (t >= 6 && t < 12) {
+        z = 2;
+    }
+
+    else if (t >= 12 && t < 16) {
+        climb(12, 2, 6);
+    }
+
+    else if (t >= 16) {
+        z = 8;
+    }
+}
+
+// Returns true if every hover settles
+static bool checkAltitude(void)
+{
+    static const float GRAVITY = 9.80665;
+
+    Random random(23);
+
+    // Tilted 15 deg in roll and 10 in pitch throughout
+    const VehicleState tilted(
+            0, 0, 0, 0, 0, 0, 15 * M_PI / 180, 0, -10 * M_PI / 180, 0, 0, 0);
+
+    AltitudeEstimator estimator;
+
+    const auto steps = (uint32_t)(HOVERS[1].end / ALT_DT + 0.5f);
+
+    const auto rangeSteps = (uint32_t)(RANGE_PERIOD / ALT_DT + 0.5f);
+    const auto baroSteps = (uint32_t)(BARO_PERIOD / ALT_DT + 0.5f);
+
+    uint8_t hover = 0;
+    float zError = 0;
+    float dzError = 0;
+    bool converged = true;
+
+    for (uint32_t k=1; k<=steps; ++k) {
+
+        const auto t = k * ALT_DT;
+
+        float z = 0, dz = 0, ddz = 0;
+        altitudeProfile(t, z, dz, ddz);
+
+        if (k % rangeSteps == 0) {
+            estimator.setRange(
+                    z / tilted.cosTilt() + 0.01f * random.gaussian(), tilted);
+        }
+
+        if (k % baroSteps == 0) {
+            estimator.setBaroAltitude(
+                    BARO_OFFSET + z + 0.3f * random.gaussian());
+        }
+
+        // Specific force along the body's up vector, with a bias on the
+        // vertical axis
+        const auto g = 1 + ddz / GRAVITY;
+        const Axes accel(
+                g * tilted.pitchTilt() + 0.02f * random.gaussian(),
+                g * tilted.rollTilt() + 0.02f * random.gaussian(),
+                g * tilted.cosTilt() + 0.03f + 0.02f * random.gaussian());
+
+        estimator.update(ALT_DT, tilted, &accel);
+
+        VehicleState vstate;
+        estimator.get(vstate);
+
+        if (t > HOVERS[hover].end - 1) {
+            zError = fmaxf(zError, fabsf(vstate.z - z));
+            dzError = fmaxf(dzError, fabsf(vstate.dz - dz));
+        }
+
+        if (k == (uint32_t)(HOVERS[hover].end / ALT_DT + 0.5f)) {
+
+            const auto & h = HOVERS[hover];
+
+            const auto ok =
+                zError <= h.zTolerance && dzError <= h.dzTolerance;
+
+            printf("  %-7s %s   z within %.3f m (%.2f), dz within %.3f m/s "
+                    "(%.2f)\n",
+                    h.name, ok ? "ok  " : "FAIL",
+                    zError, h.zTolerance, dzError, h.dzTolerance);
+
+            converged = converged && ok;
+
+            zError = 0;
+            dzError = 0;
+            ++hover;
+        }
+    }
+
+    return converged;
+}
+
+// Main -----------------------------------------------------------------------
+
+static int check(const char * dir)
+{
+    table_t inputs;
+    table_t golden[STAGE_COUNT];
+    table_t actual[STAGE_COUNT];
+
+    if (!load(path(dir, "inputs"), inputs)) {
+        return 1;
+    }
+
+    for (uint8_t s=0; s<STAGE_COUNT; ++s) {
+        if (!load(path(dir, STAGES[s].name), golden[s])) {
+            return 1;
+        }
+    }
+
+    runStages(inputs, golden, actual);
+
+    printf("%u loops from %s\n", (unsigned)inputs.size(), dir);
+
+    const char * firstFailure = nullptr;
+
+    for (uint8_t s=0; s<STAGE_COUNT; ++s) {
+        if (!compare(STAGES[s], golden[s], actual[s]) && !firstFailure) {
+            firstFailure = STAGES[s].name;
+        }
+    }
+
+    if (firstFailure) {
+        printf("Divergence starts in the %s stage\n", firstFailure);
+        return 1;
+    }
+
+    printf("All stages match\n");
+
+    if (!checkAltitude()) {
+        printf("Altitude estimate does not converge\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+// Each stage runs on the newly recorded output of the stages before it
+static int record(const char * dir)
+{
+    table_t inputs;
+    table_t golden[STAGE_COUNT];
+
+    if (!load(path(dir, "inputs"), inputs)) {
+        return 1;
+    }
+
+    runGyroAndFusion(inputs, golden[0], golden[1]);
+    runAngle(inputs, golden[0], golden[1], golden[2]);
+    runMixer(inputs, golden[2], golden[3]);
+
+    for (uint8_t s=0; s<STAGE_COUNT; ++s) {
+        if (!save(path(dir, STAGES[s].name), STAGES[s].columns, golden[s])) {
+            return 1;
+        }
+    }
+
+    printf("Recorded %u loops to %s\n", (unsigned)inputs.size(), dir);
+
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    const char * command = argc > 1 ? argv[1] : "check";
+    const char * dir = argc > 2 ? argv[2] : "traces";
+
+    if (!strcmp(command, "check")) {
+        return check(dir);
+    }
+
+    if (!strcmp(command, "record")) {
+        return record(dir);
+    }
+
+    if (!strcmp(command, "synthesize")) {
+
+        table_t inputs;
+        synthesize(inputs);
+
+        return save(path(dir, "inputs"), INPUT_COLUMNS, inputs) ?
+            record(dir) :
+            1;
+    }
+
+    fprintf(stderr, "Usage: %s [check | record | synthesize] [DIR]\n",
+            argv[0]);
+
+    return 1;
+}
@@ -0,0 +1,288 @@
+#!/usr/bin/python3
+'''
+Host side of hardware-in-the-loop flight: simulates a quadcopter, streams its
+gyro, accelerometer and receiver values to the board at a fixed rate, and
+flies the simulation with the motor values the board sends back.  The frame
+format is described in src/hilprotocol.h.
+
+Usage: hilsim.py PORT [--rate HZ] [--duration SEC]
+
+The vehicle rests with the throttle down while the board calibrates its gyro,
+is armed, and then hovers while small stick inputs wiggle it.  The rotational
+dynamics are simple (motor differences give angular acceleration, with
+drag), and the accelerometer reports gravity in the body frame, as if the
+vehicle's altitude were held.
+
+Copyright (c) 2023 Simon D. Levy
+
+This file is part of Hackflight.
+
+Hackflight is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Hackflight is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Hackflight. If not, see <https://www.gnu.org/licenses/>.
+'''
+
+from argparse import ArgumentParser
+from math import cos, sin, pi
+from struct import Struct
+import time
+
+from serial import Serial
+
+SYNC = bytes((0xA5, 0x5A))
+
+SENSORS = ord('S')
+MOTORS = ord('M')
+
+# Payloads: sequence, gyro[3], accel[3], channels[6], lost-frame flag; and
+# sequence, motors[4]
+SENSORS_PAYLOAD = Struct('<Hhhhhhh6HB')
+MOTORS_PAYLOAD = Struct('<H4H')
+
+MOTORS_FRAME_SIZE = 4 + MOTORS_PAYLOAD.size + 1
+
+# Raw sensor scales of the SoftQuatImu defaults: +/-2000 deg/sec, +/-16 g
+GYRO_LSB_PER_DPS = 32768 / 2000
+ACCEL_LSB_PER_G = 32768 / 16
+
+# SBUS channel range
+SBUS_MIN = 172
+SBUS_MAX = 1811
+
+# Roll, pitch, yaw sign of each motor, in QuadXbfMixer order
+SPINS = ((-1, +1, -1),   # rear right
+         (-1, -1, +1),   # front right
+         (+1, +1, +1),   # rear left
+         (+1, -1, -1))   # front left
+
+# Angular acceleration (deg/sec^2) per unit of motor difference, per axis;
+# yaw is negative because the controller negates its yaw demand
+TORQUE_GAINS = 20000, 20000, -8000
+
+# Angular drag, 1/sec
+DRAG = 5
+
+# Schedule, in seconds: at rest for gyro calibration, then armed
+ARM_SEC = 3
+TAKEOFF_SEC = 4
+
+HOVER_THROTTLE = 0.5
+
+
+def crc8(data):
+    '''CRC-8/DVB-S2, as Hil::crc8()'''
+
+    crc = 0
+
+    for c in data:
+        crc ^= c
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0xD5 if crc & 0x80 else crc << 1) & 0xFF
+
+    return crc
+
+
+def frame(msgtype, payload):
+
+    body = bytes((msgtype, len(payload))) + payload
+
+    return SYNC + body + bytes((crc8(body),))
+
+
+def sbus(value):
+    '''[-1,+1] => SBUS'''
+
+    return int(SBUS_MIN + (value + 1) / 2 * (SBUS_MAX - SBUS_MIN))
+
+
+class Vehicle(object):
+
+    def __init__(self):
+
+        self.rates = [0.0] * 3   # roll, pitch, yaw deg/sec
+        self.angles = [0.0] * 3  # deg
+        self.motors = [0.0] * 4
+
+    def update(self, dt):
+
+        for axis in range(3):
+
+            torque = sum(spin[axis] * motor
+                         for spin, motor in zip(SPINS, self.motors))
+
+            self.rates[axis] += (TORQUE_GAINS[axis] * torque -
+                                 DRAG * self.rates[axis]) * dt
+
+            self.angles[axis] += self.rates[axis] * dt
+
+    def get_gyro(self):
+
+        return [clip(rate * GYRO_LSB_PER_DPS) for rate in self.rates]
+
+    def get_accel(self):
+
+        phi, theta = (angle * pi / 180 for angle in self.angles[:2])
+
+        # Gravity in the body frame
+        g = (-sin(theta), sin(phi) * cos(theta), cos(phi) * cos(theta))
+
+        return [clip(axis * ACCEL_LSB_PER_G) for axis in g]
+
+
+def clip(value):
+
+    return max(-32768, min(32767, int(value)))
+
+
+def get_sticks(t):
+    '''Throttle, roll, pitch, yaw, aux1, aux2 in [-1,+1] at time t'''
+
+    if t < ARM_SEC:
+        return -1, 0, 0, 0, -1, -1
+
+    if t < TAKEOFF_SEC:
+        return -1, 0, 0, 0, +1, -1
+
+    wiggle = 0.1 * sin(2 * pi * 0.5 * (t - TAKEOFF_SEC))
+
+    return 2 * HOVER_THROTTLE - 1, wiggle, -wiggle, 0, +1, -1
+
+
+class MotorsParser(object):
+
+    def __init__(self):
+
+        self.buffer = bytearray()
+
+    def parse(self, data):
+        '''Returns a list of (sequence, motors) from complete frames'''
+
+        buf = self.buffer
+        buf += data
+
+        frames = []
+        start = 0
+
+        while True:
+
+            start = buf.find(SYNC, start)
+
+            if start < 0:
+                start = len(buf) - (1 if buf.endswith(SYNC[:1]) else 0)
+                break
+
+            if len(buf) - start < MOTORS_FRAME_SIZE:
+                break
+
+            body = buf[start+2:start+MOTORS_FRAME_SIZE-1]
+
+            if (body[0] == MOTORS and body[1] == MOTORS_PAYLOAD.size and
+                    crc8(body) == buf[start+MOTORS_FRAME_SIZE-1]):
+                seq, *motors = MOTORS_PAYLOAD.unpack(bytes(body[2:]))
+                frames.append((seq, [m / 65535 for m in motors]))
+                start += MOTORS_FRAME_SIZE
+
+            else:
+                start += 1
+
+        del buf[:start]
+
+        return frames
+
+
+def main():
+
+    argparser = ArgumentParser()
+
+    argparser.add_argument('port', help='board serial port or pseudo-terminal')
+    argparser.add_argument('-r', '--rate', type=int, default=1000,
+                           help='samples per second')
+    argparser.add_argument('-d', '--duration', type=float, default=0,
+                           help='seconds to run (default: until stopped)')
+
+    args = argparser.parse_args()
+
+    port = Serial(args.port, 2000000, timeout=0)
+
+    vehicle = Vehicle()
+    parser = MotorsParser()
+
+    dt = 1 / args.rate
+
+    # Send times by sequence number, for round-trip latency
+    sent = {}
+    latencies = []
+
+    seq = 0
+    count = 0
+    start = time.monotonic()
+    deadline = start
+
+    try:
+
+        while args.duration == 0 or deadline - start < args.duration:
+
+            # Hold to the sample rate
+            deadline += dt
+            while time.monotonic() < deadline:
+                for reply, motors in parser.parse(port.read(4096)):
+                    if reply in sent:
+                        latencies.append(time.monotonic() - sent.pop(reply))
+                    vehicle.motors = motors
+
+            t = deadline - start
+
+            vehicle.update(dt)
+
+            sticks = get_sticks(t)
+
+            payload = SENSORS_PAYLOAD.pack(
+                    seq,
+                    *vehicle.get_gyro(),
+                    *vehicle.get_accel(),
+                    *(sbus(stick) for stick in sticks),
+                    0)
+
+            port.write(frame(SENSORS, payload))
+
+            sent[seq] = time.monotonic()
+            seq = (seq + 1) & 0xFFFF
+            count += 1
+
+            if count % args.rate == 0:
+                print('t=%5.1f  roll=%+6.1f  pitch=%+6.1f  yaw=%+6.1f deg' %
+                      ((t,) + tuple(vehicle.angles)))
+
+    except KeyboardInterrupt:
+
+        pass
+
+    # Let the last replies come in
+    time.sleep(0.1)
+    for reply, _ in parser.parse(port.read(4096)):
+        if reply in sent:
+            latencies.append(time.monotonic() - sent.pop(reply))
+
+    port.close()
+
+    elapsed = time.monotonic() - start
+
+    print('Sent %d samples in %.1f sec (%.0f/sec); %d answered' %
+          (count, elapsed, count / elapsed, len(latencies)))
+
+    if latencies:
+        latencies.sort()
+        print('Round trip: median %.2f msec, 99th percentile %.2f msec' %
+              (1000 * latencies[len(latencies) // 2],
+               1000 * latencies[int(len(latencies) * 0.99)]))
+
+
+main()
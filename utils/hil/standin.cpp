@@ -0,0 +1,169 @@
+/*
+   Stand-in for a board running the hardware-in-the-loop sketch, so that the
+   HIL protocol and the host simulator can be exercised on Linux.  It listens
+   on a pseudo-terminal, decodes SENSORS frames with the firmware's own Hil
+   class, and answers each with a MOTORS frame from the firmware's QuadXbf
+   mixer, driven by the stick demands and a simple gyro-rate damper in place
+   of the flight controller.  Motors stay off until the Aux1 switch is up.
+
+   Usage: standin [LINK]
+
+   The pseudo-terminal's name is printed; given LINK, a symbolic link to it
+   is made there too, for the host simulator to open.
+
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <hilprotocol.h>
+#include <core/mixers/fixedpitch/quadxbf.h>
+
+// SBUS channel range, as in Logic::setSbusValues()
+static const float SBUS_MIN = 172;
+static const float SBUS_MAX = 1811;
+
+// Gyro scale of the SoftQuatImu default, deg/sec at full scale
+static const float GYRO_SCALE_DPS = 2000;
+
+// Rate-damping gain, demand per deg/sec
+static const float DAMPING = 0.002;
+
+static float scaleChannel(const uint16_t value)
+{
+    return 2 * (value - SBUS_MIN) / (SBUS_MAX - SBUS_MIN) - 1;
+}
+
+static float scaleGyro(const int16_t raw)
+{
+    return raw * GYRO_SCALE_DPS / 32768;
+}
+
+static void getMotors(Mixer & mixer, Hil & hil, float motors[])
+{
+    int16_t rawGyro[3] = {};
+    hil.getRawGyro(rawGyro);
+
+    const auto channels = hil.getChannels();
+
+    // Disarmed
+    if (scaleChannel(channels[4]) < 0) {
+        return;
+    }
+
+    Demands demands(
+            (scaleChannel(channels[0]) + 1) / 2,
+            scaleChannel(channels[1]) - DAMPING * scaleGyro(rawGyro[0]),
+            scaleChannel(channels[2]) - DAMPING * scaleGyro(rawGyro[1]),
+            scaleChannel(channels[3]) + DAMPING * scaleGyro(rawGyro[2]));
+
+    mixer.getMotors(demands, motors);
+}
+
+int main(int argc, char ** argv)
+{
+    const auto fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0) {
+        perror("posix_openpt");
+        return 1;
+    }
+
+    const auto name = ptsname(fd);
+
+    // Raw bytes both ways, whatever the host does with the other end
+    struct termios tio = {};
+    const auto slave = open(name, O_RDWR | O_NOCTTY);
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    close(slave);
+
+    if (argc > 1) {
+        unlink(argv[1]);
+        if (symlink(name, argv[1]) < 0) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    printf("Stand-in board on %s\n", name);
+    fflush(stdout);
+
+    Hil hil;
+
+    auto mixer = QuadXbfMixer::make();
+
+    uint32_t frames = 0;
+
+    // Reads fail while nobody has the other end open: before the host
+    // opens it, we wait; after the host closes it, we're done
+    bool hostSeen = false;
+
+    while (true) {
+
+        uint8_t buf[256] = {};
+
+        const auto count = read(fd, buf, sizeof(buf));
+
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EIO && !hostSeen) {
+                usleep(10000);
+                continue;
+            }
+            break;
+        }
+
+        for (auto k=0; k<count; ++k) {
+
+            if (hil.parse(buf[k])) {
+
+                float motors[Mixer::MAX_MOTORS] = {};
+
+                getMotors(mixer, hil, motors);
+
+                hil.setMotors(motors);
+
+                uint8_t frame[Hil::MOTORS_FRAME_SIZE] = {};
+
+                if (write(fd, frame, hil.getMotorsFrame(frame)) < 0) {
+                    perror("write");
+                }
+
+                ++frames;
+                hostSeen = true;
+            }
+        }
+    }
+
+    printf("Answered %u SENSORS frames\n", frames);
+
+    if (argc > 1) {
+        unlink(argv[1]);
+    }
+
+    return 0;
+}
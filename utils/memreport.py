@@ -0,0 +1,254 @@
+#!/usr/bin/python3
+'''
+Reports static RAM and flash use per Hackflight subsystem, from the symbol
+table and debugging information of a firmware ELF file
+
+Copyright (C) 2023 Simon D. Levy
+
+MIT License
+'''
+
+from argparse import ArgumentParser
+from subprocess import check_output
+import re
+
+# Demangled-name prefixes for each subsystem; first match wins
+SUBSYSTEMS = (
+    ('imu',       ('Imu', 'SoftQuatImu', 'LadybugImu', 'Usfs', 'Mpu')),
+    ('pids',      ('PidController', 'AnglePidController',
+                   'AltHoldPidController', 'FlowHoldPidController',
+                   'SetPointPid')),
+    ('filters',   ('Pt1Filter', 'Pt2Filter', 'BiquadFilter', 'KalmanFilter',
+                   'PrecisePt1Filter', 'PrecisePt2Filter', 'CompensatedState',
+                   'FilterChain', 'Lowpass', 'Notch')),
+    ('mixer',     ('Mixer', 'FixedPitchMixer', 'QuadXbfMixer')),
+    ('esc',       ('Esc', 'BrushedEsc', 'DshotEsc', 'MockEsc', 'Stm32Dshot',
+                   'Stm32F4Dshot')),
+    ('scheduler', ('Scheduler', 'Task', 'AccelerometerTask', 'AttitudeTask',
+                   'ReceiverTask', 'SkyrangerTask', 'VisualizerTask')),
+    ('msp',       ('Msp',)),
+    ('logic',     ('Logic',)),
+    ('board',     ('Stm32Board', 'Stm32FBoard', 'Stm32F4Board',
+                   'LadybugBoard')),
+)
+
+# Attributes whose values we need from the DWARF dump
+DIE_ATTRIBUTES = ('DW_AT_name', 'DW_AT_type', 'DW_AT_specification',
+                  'DW_AT_location')
+
+# DWARF tags that name a type
+NAMED_TYPES = ('DW_TAG_class_type', 'DW_TAG_structure_type',
+               'DW_TAG_union_type', 'DW_TAG_base_type',
+               'DW_TAG_enumeration_type')
+
+
+def subsystem(name):
+
+    for subsys, prefixes in SUBSYSTEMS:
+        for prefix in prefixes:
+            if (name == prefix or name.startswith(prefix + '::') or
+                    name.startswith(prefix + '<')):
+                return subsys
+
+    return 'other'
+
+
+def read_dies(readelf, elf):
+    '''Debugging-information entries by offset, as (tag, attributes)'''
+
+    output = check_output([readelf, '--debug-dump=info', elf])
+
+    dies = {}
+    attributes = None
+
+    for line in output.decode(errors='replace').splitlines():
+
+        # Start of an entry: " <1><8c7d>: Abbrev Number: 201 (DW_TAG_variable)"
+        match = re.match(r'\s*<\d+><([0-9a-f]+)>: Abbrev Number: \d+ \((\w+)\)',
+                         line)
+
+        if match:
+            attributes = {}
+            dies[int(match.group(1), 16)] = match.group(2), attributes
+            continue
+
+        # Attribute: "    <8c7f>   DW_AT_name        : ... : stderr"
+        match = re.match(r'\s*<[0-9a-f]+>\s+(DW_AT_\w+)\s*: (.*)', line)
+
+        if match and attributes is not None:
+
+            name, value = match.groups()
+
+            if name not in DIE_ATTRIBUTES:
+                continue
+
+            if name == 'DW_AT_name':
+                value = value.split('): ')[-1].strip()
+
+            elif name == 'DW_AT_location':
+                addr = re.search(r'DW_OP_addr: ([0-9a-f]+)\)', value)
+                if addr is None:
+                    continue
+                value = int(addr.group(1), 16)
+
+            else:
+                ref = re.search(r'<0x([0-9a-f]+)>', value)
+                if ref is None:
+                    continue
+                value = int(ref.group(1), 16)
+
+            attributes[name] = value
+
+    return dies
+
+
+def type_name(dies, offset):
+    '''Name of a type, through any typedefs, qualifiers and arrays'''
+
+    while offset in dies:
+
+        tag, attributes = dies[offset]
+
+        if tag in NAMED_TYPES and 'DW_AT_name' in attributes:
+            return attributes['DW_AT_name']
+
+        if 'DW_AT_type' not in attributes:
+            break
+
+        offset = attributes['DW_AT_type']
+
+    return None
+
+
+def variable_types(dies):
+    '''Type names of statically allocated variables, by address'''
+
+    types = {}
+
+    for tag, attributes in dies.values():
+
+        if tag != 'DW_TAG_variable' or 'DW_AT_location' not in attributes:
+            continue
+
+        # A definition may point back to its declaration for the type
+        if ('DW_AT_type' not in attributes and
+                attributes.get('DW_AT_specification') in dies):
+            attributes = dict(dies[attributes['DW_AT_specification']][1],
+                              **attributes)
+
+        if 'DW_AT_type' in attributes:
+            name = type_name(dies, attributes['DW_AT_type'])
+            if name is not None:
+                types[attributes['DW_AT_location']] = name
+
+    return types
+
+
+def read_sections(readelf, elf):
+    '''(in flash, in RAM) by section index'''
+
+    output = check_output([readelf, '-SW', elf])
+
+    sections = {}
+
+    for line in output.decode().splitlines():
+
+        match = re.match(r'\s*\[\s*(\d+)\]\s+(\S+)\s+(\S+)\s+[0-9a-f]+ '
+                         r'[0-9a-f]+ [0-9a-f]+ [0-9a-f]+\s+(\w*)', line)
+
+        if match:
+
+            index, _name, sectype, flags = match.groups()
+
+            if 'A' not in flags:
+                continue
+
+            # Anything with an image takes flash, including initialized
+            # data; only writable sections (.data, .bss, and their
+            # fast-memory counterparts) take RAM
+            sections[int(index)] = sectype != 'NOBITS', 'W' in flags
+
+    return sections
+
+
+def main():
+
+    argparser = ArgumentParser()
+
+    argparser.add_argument('elf', help='firmware ELF file, built with -g')
+
+    argparser.add_argument('-r', '--readelf', default='arm-none-eabi-readelf',
+                           help='readelf program for the target toolchain')
+
+    argparser.add_argument('-v', '--verbose', action='store_true',
+                           help='list the largest symbols in each subsystem')
+
+    args = argparser.parse_args()
+
+    sections = read_sections(args.readelf, args.elf)
+
+    # Objects such as the sketch's board, IMU and PID controllers have
+    # names of their own choosing, so they are attributed by type
+    types = variable_types(read_dies(args.readelf, args.elf))
+
+    output = check_output([args.readelf, '-sW', '--demangle', args.elf])
+
+    totals = {}
+    symbols = {}
+
+    for line in output.decode().splitlines():
+
+        fields = line.split(None, 7)
+
+        if len(fields) < 8 or not fields[6].isdigit():
+            continue
+
+        addr = int(fields[1], 16)
+        size = int(fields[2])
+        index = int(fields[6])
+        name = fields[7].split('@')[0]
+
+        if size == 0 or index not in sections:
+            continue
+
+        in_flash, in_ram = sections[index]
+
+        typename = types.get(addr) if fields[3] == 'OBJECT' else None
+
+        subsys = subsystem(name) if typename is None else subsystem(typename)
+
+        if typename is not None:
+            name = '%s (%s)' % (name, typename)
+
+        if subsys not in totals:
+            totals[subsys] = [0, 0]
+            symbols[subsys] = []
+
+        if in_flash:
+            totals[subsys][0] += size
+
+        if in_ram:
+            totals[subsys][1] += size
+
+        symbols[subsys].append((size, name))
+
+    print('%-10s %10s %10s' % ('subsystem', 'flash', 'ram'))
+
+    flash = 0
+    ram = 0
+
+    for subsys in sorted(totals, key=lambda s: -sum(totals[s])):
+
+        print('%-10s %10d %10d' % (subsys, *totals[subsys]))
+
+        flash += totals[subsys][0]
+        ram += totals[subsys][1]
+
+        if args.verbose:
+            for size, name in sorted(symbols[subsys])[-5:][::-1]:
+                print('    %8d %s' % (size, name))
+
+    print('%-10s %10d %10d' % ('total', flash, ram))
+
+
+main()
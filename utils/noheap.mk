@@ -0,0 +1,12 @@
+# Heap-free build option for the example Makefiles.
+#
+# Building with NOHEAP=1 wraps the allocator entry points, so the link fails
+# with "undefined reference to __wrap_malloc" (etc.) naming whatever object
+# pulled in the heap.
+
+NOHEAP_SYMBOLS = malloc _malloc_r calloc _calloc_r realloc _realloc_r _Znwj _Znaj
+
+ifeq ($(NOHEAP),1)
+NOHEAP_PROPERTY = --build-property \
+	"compiler.c.elf.extra_flags=$(foreach s,$(NOHEAP_SYMBOLS),-Wl,--wrap=$(s))"
+endif
@@ -0,0 +1,177 @@
+/*
+   Stress test of SeqLock on the host: a writer thread publishes numbered
+   frames while the main thread polls them, checking every frame it gets
+   for tearing (fields from different writes) and for going backward.  The
+   frame has the layout of ReceiverTask's.
+
+   Usage: seqlockstress [SECONDS]
+
+   The writer yields after each frame and the reader spins, so on a single
+   core the reader is regularly preempted in the middle of a read and the
+   writer publishes a frame before it resumes; on more cores the two run
+   against each other outright.
+
+   Exits nonzero if any frame read was torn or out of order.  Failed reads
+   are counted but allowed: on the host the writer can be preempted in the
+   middle of a write, or be mid-write on both of the reader's attempts,
+   neither of which can happen to an interrupt on the flight controller.
+
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <thread>
+
+#include <core/seqlock.h>
+
+// Run time when none is given
+static const uint32_t DEFAULT_SECONDS = 5;
+
+typedef struct {
+
+    float    channels[6];
+    uint32_t usec;
+    uint32_t count;
+    bool     lostSignal;
+
+} frame_t;
+
+// Every field is a function of the frame number, so a mix of two frames
+// shows up as a mismatch
+static void fill(frame_t & frame, const uint32_t count)
+{
+    for (uint8_t k=0; k<6; ++k) {
+        frame.channels[k] = (float)(count & 0xffff) + k;
+    }
+
+    frame.usec = count * 3;
+    frame.count = count;
+    frame.lostSignal = count & 1;
+}
+
+static bool consistent(const frame_t & frame)
+{
+    frame_t expected = {};
+    fill(expected, frame.count);
+
+    for (uint8_t k=0; k<6; ++k) {
+        if (frame.channels[k] != expected.channels[k]) {
+            return false;
+        }
+    }
+
+    return
+        frame.usec == expected.usec &&
+        frame.lostSignal == expected.lostSignal;
+}
+
+static SeqLock<frame_t> published;
+
+static bool stop;
+
+static uint32_t framesWritten;
+
+static void writer(void)
+{
+    frame_t frame = {};
+
+    uint32_t count = 0;
+
+    while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+        fill(frame, ++count);
+        published.write(frame);
+        std::this_thread::yield();
+    }
+
+    framesWritten = count;
+}
+
+int main(int argc, char ** argv)
+{
+    const uint32_t seconds = argc > 1 ? atol(argv[1]) : DEFAULT_SECONDS;
+
+    if (seconds == 0) {
+        fprintf(stderr, "Usage: %s [SECONDS]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t reads = 0;
+    uint64_t misses = 0;
+    uint64_t torn = 0;
+    uint64_t backward = 0;
+    uint64_t distinct = 0;
+
+    uint32_t lastCount = 0;
+
+    const auto end =
+        std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+
+    std::thread thread(writer);
+
+    // Checking the clock is slow next to a read, so do it once per batch
+    while (std::chrono::steady_clock::now() < end) {
+
+        for (uint16_t k=0; k<1000; ++k) {
+
+            frame_t frame = {};
+
+            ++reads;
+
+            if (!published.read(frame)) {
+                ++misses;
+            }
+
+            else if (frame.count != 0) {
+
+                if (!consistent(frame)) {
+                    ++torn;
+                }
+
+                else if (frame.count < lastCount) {
+                    ++backward;
+                }
+
+                else {
+                    distinct += frame.count != lastCount;
+                    lastCount = frame.count;
+                }
+            }
+        }
+    }
+
+    __atomic_store_n(&stop, true, __ATOMIC_RELAXED);
+
+    thread.join();
+
+    printf("%u frames written, %llu reads\n",
+            (unsigned)framesWritten, (unsigned long long)reads);
+    printf("  distinct frames read %llu\n", (unsigned long long)distinct);
+    printf("  failed reads         %llu\n", (unsigned long long)misses);
+    printf("  torn frames          %llu\n", (unsigned long long)torn);
+    printf("  out of order         %llu\n", (unsigned long long)backward);
+
+    const auto ok = torn == 0 && backward == 0 && distinct > 1;
+
+    printf("%s\n", ok ? "No torn frames" : "FAILED");
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,640 @@
+/*
+   Software-in-the-loop server for a swarm of vehicles.  Each vehicle gets its
+   own angle and altitude-hold PID controllers, parameters, and QuadXbf mixer,
+   and speaks the multisim.rs protocol on its own pair of UDP ports:
+
+      telemetry in  5001 + 2 * i: 17 little-endian doubles (time, x, dx, y,
+                    dy, z, dz, phi, dphi, theta, dtheta, psi, dpsi in NED
+                    radians, then throttle, roll, pitch, yaw sticks in
+                    [-1,+1]); a negative time means the simulation has halted
+
+      motors out    5000 + 2 * i: 4 little-endian doubles in [0,1]
+
+   plus an MSP port, MSP_BASE + i, that answers the RC and ATTITUDE requests
+   the way the firmware does, so that hfviz and hfrecord can watch any
+   vehicle over udp://.
+
+   All sockets are watched by one epoll thread, which keeps only the newest
+   telemetry packet of each vehicle and hands vehicles with new telemetry to
+   a pool of worker threads.  A vehicle is never on more than one worker at a
+   time, and one whose client is slow or gone holds up nobody else.
+
+   Usage: swarm [-n VEHICLES] [-t THREADS] [-r LOOP_HZ] [-p PORT_BASE]
+                [-m MSP_BASE]
+
+   Copyright (c) 2023 Simon D. Levy
+
+   This file is part of Hackflight.
+
+   Hackflight is free software: you can redistribute it and/or modify it under
+   the terms of the GNU General Public License as published by the Free
+   Software Foundation, either version 3 of the License, or (at your option)
+   any later version.
+
+   Hackflight is distributed in the hope that it will be useful, but WITHOUT
+   ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+   FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+   more details.
+
+   You should have received a copy of the GNU General Public License along with
+   Hackflight. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <core/mixers/fixedpitch/quadxbf.h>
+#include <core/parameters.h>
+#include <core/pids/angle.h>
+#include <core/pids/setpoints/althold.h>
+#include <msp.h>
+
+static const uint8_t TELEMETRY_COUNT = 17;
+static const uint8_t MOTOR_COUNT = 4;
+
+// Throttle stick below which the PID controllers are reset, as in
+// multisim.rs
+static const float PID_RESET_THROTTLE = 0.05;
+
+static const float RAD2DEG = 180 / M_PI;
+
+static volatile sig_atomic_t _stopping;
+
+class Vehicle {
+
+    public:
+
+        // Set up once, before the threads start
+        uint16_t index;
+        int telemetrySocket;
+        int mspSocket;
+        struct sockaddr_in motorAddr;
+
+        // Guards the fields below, which the epoll thread and the worker
+        // both touch
+        std::mutex lock;
+
+        double telemetry[TELEMETRY_COUNT];
+        bool haveTelemetry;
+        bool queued;
+
+        // Latest Euler angles and sticks, for MSP
+        float angles[3];
+        float sticks[4];
+
+        uint32_t steps;
+        uint32_t superseded;
+        uint32_t halts;
+
+        // Worker-only: at most one worker has the vehicle at a time
+        AnglePidController anglePid;
+        AltHoldPidController altHoldPid;
+        Parameters params;
+        Mixer mixer;
+
+        double prevTime;
+        float prevRates[3];
+
+        // Epoll-thread only
+        Msp msp;
+
+        Vehicle(void)
+            : mixer(QuadXbfMixer::make()), msp()
+        {
+            memset(telemetry, 0, sizeof(telemetry));
+            memset(angles, 0, sizeof(angles));
+            memset(sticks, 0, sizeof(sticks));
+
+            haveTelemetry = false;
+            queued = false;
+
+            steps = 0;
+            superseded = 0;
+            halts = 0;
+
+            restart();
+        }
+
+        // Fresh controllers for a new flight
+        void restart(void)
+        {
+            anglePid = AnglePidController();
+            altHoldPid = AltHoldPidController();
+
+            PidController::setLoopDt(params.dt, anglePid, altHoldPid);
+
+            prevTime = -1;
+            memset(prevRates, 0, sizeof(prevRates));
+        }
+
+}; // class Vehicle
+
+// Vehicles waiting for a worker
+class WorkQueue {
+
+    private:
+
+        std::mutex m_lock;
+        std::condition_variable m_ready;
+        std::deque<Vehicle *> m_vehicles;
+        bool m_closed;
+
+    public:
+
+        WorkQueue(void)
+        {
+            m_closed = false;
+        }
+
+        void put(Vehicle * vehicle)
+        {
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                m_vehicles.push_back(vehicle);
+            }
+
+            m_ready.notify_one();
+        }
+
+        // Returns nullptr once closed
+        Vehicle * get(void)
+        {
+            std::unique_lock<std::mutex> guard(m_lock);
+
+            m_ready.wait(guard,
+                    [this]{ return m_closed || !m_vehicles.empty(); });
+
+            if (m_closed) {
+                return nullptr;
+            }
+
+            auto vehicle = m_vehicles.front();
+            m_vehicles.pop_front();
+
+            return vehicle;
+        }
+
+        void close(void)
+        {
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                m_closed = true;
+            }
+
+            m_ready.notify_all();
+        }
+
+}; // class WorkQueue
+
+// Telemetry (NED radians) => vehicle state as the firmware keeps it (ENU,
+// degrees, pitch reversed), as in multisim.rs
+static void getVehicleState(const double telemetry[], VehicleState & vstate)
+{
+    vstate.x      =  telemetry[1];
+    vstate.dx     =  telemetry[2];
+    vstate.y      =  telemetry[3];
+    vstate.dy     =  telemetry[4];
+    vstate.z      = -telemetry[5];
+    vstate.dz     = -telemetry[6];
+    vstate.phi    =  RAD2DEG * telemetry[7];
+    vstate.dphi   =  RAD2DEG * telemetry[8];
+    vstate.theta  = -RAD2DEG * telemetry[9];
+    vstate.dtheta = -RAD2DEG * telemetry[10];
+    vstate.psi    =  RAD2DEG * telemetry[11];
+    vstate.dpsi   =  RAD2DEG * telemetry[12];
+
+    // The PID controllers level from the quaternion, so we build it from the
+    // simulator's Euler angles; the firmware's pitch has the opposite sign
+    // to the usual aerospace convention
+    const float cr = cos(telemetry[7] / 2);
+    const float sr = sin(telemetry[7] / 2);
+    const float cp = cos(telemetry[9] / 2);
+    const float sp = sin(telemetry[9] / 2);
+    const float cy = cos(telemetry[11] / 2);
+    const float sy = sin(telemetry[11] / 2);
+
+    vstate.qw = cr * cp * cy + sr * sp * sy;
+    vstate.qx = sr * cp * cy - cr * sp * sy;
+    vstate.qy = cr * sp * cy + sr * cp * sy;
+    vstate.qz = cr * cp * sy - sr * sp * cy;
+}
+
+static void step(Vehicle & vehicle, const double telemetry[], float motors[])
+{
+    const auto time = telemetry[0];
+
+    // Sim sends negative time value on halt
+    if (time < 0) {
+        vehicle.restart();
+        return;
+    }
+
+    VehicleState vstate;
+
+    getVehicleState(telemetry, vstate);
+
+    // Angular acceleration, which the firmware gets from the gyro
+    const float rates[3] = { vstate.dphi, vstate.dtheta, vstate.dpsi };
+
+    const auto dt = time - vehicle.prevTime;
+
+    if (vehicle.prevTime >= 0 && dt > 0) {
+        vstate.ddphi   = (rates[0] - vehicle.prevRates[0]) / dt;
+        vstate.ddtheta = (rates[1] - vehicle.prevRates[1]) / dt;
+        vstate.ddpsi   = (rates[2] - vehicle.prevRates[2]) / dt;
+    }
+
+    vehicle.prevTime = time;
+    memcpy(vehicle.prevRates, rates, sizeof(rates));
+
+    Demands demands(telemetry[13], telemetry[14], telemetry[15], telemetry[16]);
+
+    // Reset PID controllers on zero throttle
+    const auto pidReset = demands.throttle < PID_RESET_THROTTLE;
+
+    // [-1,+1] => [0,1]
+    demands.throttle = (demands.throttle + 1) / 2;
+
+    const float sticks[4] = {
+        (float)telemetry[13],
+        (float)telemetry[14],
+        (float)telemetry[15],
+        (float)telemetry[16]
+    };
+
+    PidController::run(
+            demands,
+            vstate,
+            vehicle.params,
+            (uint32_t)(time * 1e6),
+            pidReset,
+            vehicle.anglePid,
+            vehicle.altHoldPid);
+
+    vehicle.mixer.getMotors(demands, motors);
+
+    std::lock_guard<std::mutex> guard(vehicle.lock);
+
+    vehicle.angles[0] = vstate.phi;
+    vehicle.angles[1] = vstate.theta;
+    vehicle.angles[2] = vstate.psi;
+    memcpy(vehicle.sticks, sticks, sizeof(sticks));
+}
+
+static void sendMotors(const Vehicle & vehicle, const float motors[])
+{
+    double buf[MOTOR_COUNT] = {};
+
+    for (auto k=0; k<MOTOR_COUNT; ++k) {
+        buf[k] = motors[k];
+    }
+
+    // Drop the packet rather than wait if the client isn't keeping up
+    sendto(vehicle.telemetrySocket, buf, sizeof(buf), MSG_DONTWAIT,
+            (const struct sockaddr *)&vehicle.motorAddr,
+            sizeof(vehicle.motorAddr));
+}
+
+static void work(WorkQueue & queue)
+{
+    while (true) {
+
+        auto vehicle = queue.get();
+
+        if (!vehicle) {
+            break;
+        }
+
+        double telemetry[TELEMETRY_COUNT] = {};
+
+        {
+            std::lock_guard<std::mutex> guard(vehicle->lock);
+            memcpy(telemetry, vehicle->telemetry, sizeof(telemetry));
+            vehicle->haveTelemetry = false;
+        }
+
+        float motors[Mixer::MAX_MOTORS] = {};
+
+        step(*vehicle, telemetry, motors);
+
+        if (telemetry[0] >= 0) {
+            sendMotors(*vehicle, motors);
+        }
+
+        std::lock_guard<std::mutex> guard(vehicle->lock);
+
+        if (telemetry[0] < 0) {
+            vehicle->halts++;
+        }
+        else {
+            vehicle->steps++;
+        }
+
+        // Telemetry that came in meanwhile goes to the back of the queue, so
+        // that a busy vehicle takes its turn with the others
+        if (vehicle->haveTelemetry) {
+            queue.put(vehicle);
+        }
+        else {
+            vehicle->queued = false;
+        }
+    }
+}
+
+// Drains the telemetry socket, keeping only the newest packet: a vehicle
+// that has fallen behind flies on the latest state rather than a backlog
+static void readTelemetry(Vehicle & vehicle, WorkQueue & queue)
+{
+    double latest[TELEMETRY_COUNT] = {};
+    uint32_t count = 0;
+
+    while (true) {
+
+        double buf[TELEMETRY_COUNT] = {};
+
+        const auto size = recv(vehicle.telemetrySocket, buf, sizeof(buf), 0);
+
+        if (size < 0) {
+            break;
+        }
+
+        if (size == sizeof(buf)) {
+            memcpy(latest, buf, sizeof(buf));
+            count++;
+        }
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(vehicle.lock);
+
+    vehicle.superseded += count - 1 + (vehicle.haveTelemetry ? 1 : 0);
+
+    memcpy(vehicle.telemetry, latest, sizeof(latest));
+    vehicle.haveTelemetry = true;
+
+    if (!vehicle.queued) {
+        vehicle.queued = true;
+        queue.put(&vehicle);
+    }
+}
+
+static int16_t stickToPwm(const float stick)
+{
+    return (int16_t)(1500 + 500 * stick);
+}
+
+// Answers MSP requests the way VisualizerTask does for the messages a
+// simulated vehicle has: RC and ATTITUDE
+static void readMsp(Vehicle & vehicle)
+{
+    while (true) {
+
+        uint8_t buf[256] = {};
+        struct sockaddr_in from = {};
+        socklen_t fromSize = sizeof(from);
+
+        const auto size = recvfrom(vehicle.mspSocket, buf, sizeof(buf), 0,
+                (struct sockaddr *)&from, &fromSize);
+
+        if (size < 0) {
+            break;
+        }
+
+        for (auto k=0; k<size; ++k) {
+
+            const auto messageType = vehicle.msp.parse(buf[k]);
+
+            float angles[3] = {};
+            float sticks[4] = {};
+
+            if (messageType == 105 || messageType == 108) {
+                std::lock_guard<std::mutex> guard(vehicle.lock);
+                memcpy(angles, vehicle.angles, sizeof(angles));
+                memcpy(sticks, vehicle.sticks, sizeof(sticks));
+            }
+
+            switch (messageType) {
+
+                case 105: // RC
+                    {
+                        int16_t channels[] = {
+                            stickToPwm(sticks[0]),
+                            stickToPwm(sticks[1]),
+                            stickToPwm(sticks[2]),
+                            stickToPwm(sticks[3]),
+                            stickToPwm(+1),
+                            stickToPwm(-1)
+                        };
+
+                        vehicle.msp.serializeShorts(105, channels, 6);
+                    }
+                    break;
+
+                case 108: // ATTITUDE
+                    {
+                        int16_t attitude[3] = {
+                            (int16_t)(10 * angles[0]),
+                            (int16_t)(10 * angles[1]),
+                            (int16_t)angles[2]
+                        };
+
+                        vehicle.msp.serializeShorts(108, attitude, 3);
+                    }
+                    break;
+
+                default:
+                    continue;
+            }
+
+            uint8_t reply[Msp::BUF_SIZE] = {};
+
+            const auto replySize = vehicle.msp.read(reply, sizeof(reply));
+
+            sendto(vehicle.mspSocket, reply, replySize, MSG_DONTWAIT,
+                    (const struct sockaddr *)&from, fromSize);
+        }
+    }
+}
+
+static int makeSocket(const uint16_t port)
+{
+    const auto fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "port %u: %s\n", port, strerror(errno));
+        exit(1);
+    }
+
+    return fd;
+}
+
+static void addToEpoll(const int epfd, const int fd, const uint32_t tag)
+{
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u32 = tag;
+
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        perror("epoll_ctl");
+        exit(1);
+    }
+}
+
+static void stop(int signum)
+{
+    (void)signum;
+
+    _stopping = 1;
+}
+
+static void usage(const char * name)
+{
+    fprintf(stderr,
+            "Usage: %s [-n VEHICLES] [-t THREADS] [-r LOOP_HZ] "
+            "[-p PORT_BASE] [-m MSP_BASE]\n", name);
+    exit(1);
+}
+
+int main(int argc, char ** argv)
+{
+    uint16_t vehicleCount = 1;
+    uint16_t threadCount = std::thread::hardware_concurrency();
+    float loopHz = 0;
+    uint16_t portBase = 5000;
+    uint16_t mspBase = 5762;
+
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "n:t:r:p:m:")) != -1) {
+
+        switch (opt) {
+            case 'n': vehicleCount = atoi(optarg); break;
+            case 't': threadCount = atoi(optarg); break;
+            case 'r': loopHz = atof(optarg); break;
+            case 'p': portBase = atoi(optarg); break;
+            case 'm': mspBase = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+
+    if (vehicleCount == 0 || threadCount == 0) {
+        usage(argv[0]);
+    }
+
+    const auto epfd = epoll_create1(0);
+
+    std::vector<Vehicle *> vehicles;
+
+    for (uint16_t i=0; i<vehicleCount; ++i) {
+
+        auto vehicle = new Vehicle();
+
+        vehicle->index = i;
+
+        // Controller filters are set up for the simulator's loop rate if
+        // we know it, else for the firmware's
+        if (loopHz > 0) {
+            vehicle->params.dt = 1 / loopHz;
+            vehicle->params.derive();
+            vehicle->restart();
+        }
+
+        vehicle->telemetrySocket = makeSocket(portBase + 2 * i + 1);
+        vehicle->mspSocket = makeSocket(mspBase + i);
+
+        vehicle->motorAddr.sin_family = AF_INET;
+        vehicle->motorAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        vehicle->motorAddr.sin_port = htons(portBase + 2 * i);
+
+        // Even tags are telemetry sockets, odd are MSP
+        addToEpoll(epfd, vehicle->telemetrySocket, 2 * i);
+        addToEpoll(epfd, vehicle->mspSocket, 2 * i + 1);
+
+        vehicles.push_back(vehicle);
+    }
+
+    WorkQueue queue;
+
+    std::vector<std::thread> workers;
+
+    for (auto k=0; k<threadCount; ++k) {
+        workers.push_back(std::thread(work, std::ref(queue)));
+    }
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    printf("%u vehicles on %u threads: telemetry on UDP %u, %u, ...; "
+            "MSP on UDP %u, %u, ...\n",
+            vehicleCount, threadCount, portBase + 1, portBase + 3,
+            mspBase, mspBase + 1);
+    fflush(stdout);
+
+    while (!_stopping) {
+
+        struct epoll_event events[64];
+
+        const auto count = epoll_wait(epfd, events, 64, 100);
+
+        for (auto k=0; k<count; ++k) {
+
+            const auto tag = events[k].data.u32;
+
+            auto & vehicle = *vehicles[tag / 2];
+
+            if (tag % 2 == 0) {
+                readTelemetry(vehicle, queue);
+            }
+            else {
+                readMsp(vehicle);
+            }
+        }
+    }
+
+    queue.close();
+
+    for (auto & worker : workers) {
+        worker.join();
+    }
+
+    printf("\nvehicle     steps  superseded  halts\n");
+
+    for (auto vehicle : vehicles) {
+
+        printf("%7u  %8u  %10u  %5u\n", vehicle->index, vehicle->steps,
+                vehicle->superseded, vehicle->halts);
+
+        close(vehicle->telemetrySocket);
+        close(vehicle->mspSocket);
+
+        delete vehicle;
+    }
+
+    close(epfd);
+
+    return 0;
+}
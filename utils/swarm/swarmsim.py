@@ -0,0 +1,228 @@
+#!/usr/bin/python3
+'''
+Stand-in simulator for a formation of vehicles, for exercising the swarm
+server without MulticopterSim.  Each vehicle streams multisim.rs telemetry
+to its own port at a fixed rate and flies on the motor values that come
+back.
+
+Usage: swarmsim.py [-n VEHICLES] [--rate HZ] [--duration SEC]
+
+The vehicles rest with the throttle down for a moment, then climb on a
+little more than hover throttle while small stick inputs, out of step from
+one vehicle to the next, wiggle them.  The dynamics are simple (motor
+differences give angular acceleration with drag, total thrust gives
+vertical acceleration), enough to close the loop.
+
+Copyright (c) 2023 Simon D. Levy
+
+This file is part of Hackflight.
+
+Hackflight is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later
+version.
+
+Hackflight is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+Hackflight. If not, see <https://www.gnu.org/licenses/>.
+'''
+
+from argparse import ArgumentParser
+from math import pi, sin
+from select import select
+from struct import Struct
+import socket
+import time
+
+TELEMETRY = Struct('<17d')
+MOTORS = Struct('<4d')
+
+HOST = '127.0.0.1'
+
+# Roll, pitch, yaw sign of each motor, in QuadXbfMixer order
+SPINS = ((-1, +1, -1),   # rear right
+         (-1, -1, +1),   # front right
+         (+1, +1, +1),   # rear left
+         (+1, -1, -1))   # front left
+
+# Angular acceleration (rad/sec^2) per unit of motor difference, per axis
+TORQUE_GAINS = 350, 350, -140
+
+# Angular drag, 1/sec
+DRAG = 5
+
+# Vertical acceleration (m/sec^2) at full throttle on all motors
+THRUST = 20
+GRAVITY = 9.81
+
+TAKEOFF_SEC = 1
+
+CLIMB_THROTTLE = 0.6
+
+
+class Vehicle(object):
+
+    def __init__(self, index, port_base):
+
+        self.index = index
+
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind((HOST, port_base + 2 * index))
+        self.sock.setblocking(False)
+
+        self.server = HOST, port_base + 2 * index + 1
+
+        # Roll, pitch, yaw, with pitch as the firmware has it
+        self.rates = [0.0] * 3   # rad/sec
+        self.angles = [0.0] * 3  # rad
+        self.z = 0.0             # m, up
+        self.dz = 0.0
+
+        self.motors = [0.0] * 4
+
+        self.sent = 0
+        self.replies = 0
+
+    def update(self, dt):
+
+        for axis in range(3):
+
+            torque = sum(spin[axis] * motor
+                         for spin, motor in zip(SPINS, self.motors))
+
+            self.rates[axis] += (TORQUE_GAINS[axis] * torque -
+                                 DRAG * self.rates[axis]) * dt
+
+            self.angles[axis] += self.rates[axis] * dt
+
+        self.dz += (THRUST * sum(self.motors) / 4 - GRAVITY) * dt
+        self.z += self.dz * dt
+
+        # Ground
+        if self.z < 0:
+            self.z = self.dz = 0
+
+    def send(self, t, sticks):
+
+        phi, theta, psi = self.angles
+        dphi, dtheta, dpsi = self.rates
+
+        # NED, with pitch reversed as the server expects
+        self.sock.sendto(TELEMETRY.pack(t, 0, 0, 0, 0, -self.z, -self.dz,
+                                        phi, dphi, -theta, -dtheta, psi, dpsi,
+                                        *sticks),
+                         self.server)
+        self.sent += 1
+
+    def receive(self):
+
+        while True:
+
+            try:
+                data = self.sock.recv(MOTORS.size)
+            except BlockingIOError:
+                break
+
+            if len(data) == MOTORS.size:
+                self.motors = MOTORS.unpack(data)
+                self.replies += 1
+
+    def halt(self):
+
+        self.sock.sendto(TELEMETRY.pack(-1, *[0] * 16), self.server)
+        self.sock.close()
+
+
+def get_sticks(t, index):
+    '''Throttle, roll, pitch, yaw in [-1,+1] at time t'''
+
+    if t < TAKEOFF_SEC:
+        return -1, 0, 0, 0
+
+    wiggle = 0.1 * sin(2 * pi * 0.5 * (t - TAKEOFF_SEC) + index)
+
+    return 2 * CLIMB_THROTTLE - 1, wiggle, -wiggle, 0
+
+
+def main():
+
+    argparser = ArgumentParser()
+
+    argparser.add_argument('-n', '--vehicles', type=int, default=1,
+                           help='number of vehicles')
+    argparser.add_argument('-p', '--port-base', type=int, default=5000,
+                           help='first motor port, as given to the server')
+    argparser.add_argument('-r', '--rate', type=int, default=1000,
+                           help='samples per second for each vehicle')
+    argparser.add_argument('-d', '--duration', type=float, default=0,
+                           help='seconds to run (default: until stopped)')
+
+    args = argparser.parse_args()
+
+    vehicles = [Vehicle(k, args.port_base) for k in range(args.vehicles)]
+
+    socks = {vehicle.sock: vehicle for vehicle in vehicles}
+
+    dt = 1 / args.rate
+
+    # Ticks on which we had fallen behind the sample rate
+    late = 0
+
+    count = 0
+    start = time.monotonic()
+    deadline = start
+
+    try:
+
+        while args.duration == 0 or deadline - start < args.duration:
+
+            # Hold to the sample rate, taking motor values as they come
+            deadline += dt
+            while True:
+                wait = deadline - time.monotonic()
+                if wait <= 0:
+                    late += wait < -dt
+                    break
+                ready, _, _ = select(socks, [], [], wait)
+                for sock in ready:
+                    socks[sock].receive()
+
+            t = deadline - start
+
+            for vehicle in vehicles:
+                vehicle.update(dt)
+                vehicle.send(t, get_sticks(t, vehicle.index))
+
+            count += 1
+
+            if count % args.rate == 0:
+                print('t=%5.1f  ' % t +
+                      '  '.join('%d:%+5.1fm' % (vehicle.index, vehicle.z)
+                                for vehicle in vehicles[:6]) +
+                      ('  ...' if len(vehicles) > 6 else ''))
+
+    except KeyboardInterrupt:
+
+        pass
+
+    # Let the last replies come in
+    time.sleep(0.1)
+    for vehicle in vehicles:
+        vehicle.receive()
+        vehicle.halt()
+
+    elapsed = time.monotonic() - start
+
+    sent = sum(vehicle.sent for vehicle in vehicles)
+    replies = sum(vehicle.replies for vehicle in vehicles)
+
+    print('%d vehicles: sent %d samples in %.1f sec (%.0f/sec); '
+          '%d answered (%.1f%%); %d ticks late' %
+          (len(vehicles), sent, elapsed, sent / elapsed, replies,
+           100 * replies / max(sent, 1), late))
+
+
+main()